@@ -10,9 +10,15 @@ CONFIG += c++11 \
 TARGET = blu-connect4
 
 SOURCES += \
+        src/brain/BatchPlayout.cpp \
+        src/brain/MCTS.cpp \
+        src/brain/ProofNumberSearch.cpp \
         src/brain/Solver.cpp \
+        src/engine.cpp \
+        src/enginepolicy.cpp \
         src/gamemodel.cpp \
-        src/main.cpp
+        src/main.cpp \
+        src/timemanager.cpp
 
 RESOURCES += qml.qrc \
     sounds/sounds.qrc
@@ -31,15 +37,26 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 DISTFILES +=
 
 HEADERS += \
+    src/brain/BatchPlayout.hpp \
+    src/brain/Evaluator.hpp \
+    src/brain/EvaluatorWeights.hpp \
+    src/brain/MCTS.hpp \
     src/brain/Move.hpp \
     src/brain/MoveChooser.hpp \
     src/brain/MoveSorter.hpp \
+    src/brain/MoveStatistics.hpp \
     src/brain/OpeningBook.hpp \
     src/brain/Position.hpp \
+    src/brain/ProofNumberSearch.hpp \
     src/brain/Solver.hpp \
+    src/brain/ThreatOracle.hpp \
     src/brain/TranspositionTable.hpp \
+    src/engine.hpp \
+    src/enginepolicy.hpp \
     src/gamemodel.hpp \
-    src/levelclass.hpp
+    src/levelclass.hpp \
+    src/moveresult.hpp \
+    src/timemanager.hpp
 
 OTHER_FILES += \
     src/brain/7x6.book \
@@ -24,6 +24,7 @@ Rectangle {
     property int nStone: 0
     property int evidenceColumn: 0
     property int evidenceRow: 0
+    property var lastMove // the last MoveResult dropped on the board
 
     property var playerType: [0, 0, 0] // player1 and player2 type, index 0 is never used
 
@@ -103,6 +104,11 @@ Rectangle {
         }
     }
 
+    Connections {
+        target: gamemodel
+        onMoveChoosed: root.moveChoosed(move)
+    }
+
     Keys.onPressed: {
         if (event.key === Qt.Key_Left) {
             //console.log('Left')
@@ -173,19 +179,19 @@ Rectangle {
     }
 
     function moveDown() {
-        if (sensitive && gamemodel.canPlay(selectedColumn)) {
+        if (sensitive) {
             play(selectedColumn);
         }
     }
 
     function play(column) {
-        var row = gamemodel.play(column);
-        if (row >= 0) {
+        var move = gamemodel.commitMove(column);
+        if (move.row >= 0) {
             //console.log(player);
             //chooser.visible = false;
             sensitive = false;
             highlight(selectedColumn, false)
-            dropStone(column, row);
+            dropStone(move);
         }
     }
 
@@ -200,7 +206,7 @@ Rectangle {
         evidenceColumn = column;
         evidenceRow = row;
 
-        var winner = gamemodel.whoWin();
+        var winner = lastMove.state;
         winnerR.winner = winner; // This trigger an event change on winner (listen by WinnerRect)
         switch(winner) {
         case 0: // Draw
@@ -208,12 +214,14 @@ Rectangle {
             break;
         case 1:
         case 2: // Player 1 or 2 wins
-            var wp = gamemodel.getWinningPosition();
-            wp.forEach(function(move) {
-                var c = move['column'];
-                var r = move['row'];
-                tiles[c][r].evidence1(true);
-            });
+            // bit column * rows + row of the mask, above the 32 bits of the JavaScript bitwise operators
+            for (var c = 0; c < board.columns; c++) {
+                for (var r = 0; r < board.rows; r++) {
+                    if (Math.floor(lastMove.winningCells / Math.pow(2, c * board.rows + r)) % 2 === 1) {
+                        tiles[c][r].evidence1(true);
+                    }
+                }
+            }
             break;
         default: // Continue the game
             if (player === 1) {
@@ -237,8 +245,8 @@ Rectangle {
      */
     function moveChoosed(move) {
 
-        if (move["column"] >= 0) {
-            dropStone(move["column"], move["row"]);
+        if (move.row >= 0) {
+            dropStone(move);
         } else {
             console.log("Player 2 no moves allowed.")
         }
@@ -253,11 +261,12 @@ Rectangle {
         }
     }
 
-    function dropStone(column, row) {
+    function dropStone(move) {
+        lastMove = move;
         var stone = stones[nStone++];
-        stone.player = gamemodel.lastPlayer();
-        stone.column = column;
-        stone.row = row;
+        stone.player = move.player;
+        stone.column = move.column;
+        stone.row = move.row;
         stone.y = 0;
         stone.visible = true;
         stone.fall.start();
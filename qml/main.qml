@@ -61,7 +61,6 @@ Window {
 
             Board {
                 id: board
-                objectName: "board" // For findChild to work
 
                 anchors.right: parent.right
                 anchors.bottom: parent.bottom
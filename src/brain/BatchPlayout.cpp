@@ -0,0 +1,163 @@
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "BatchPlayout.hpp"
+
+namespace GameSolver {
+namespace Connect4 {
+
+void BatchPlayout::evaluate_scalar() {
+    for(int l = 0; l < LANES; l++) {
+        uint64_t possible = (mask[l] + Position::bottom_mask) & Position::board_mask;
+        uint64_t opponent_win = Position::compute_winning_position(current_position[l] ^ mask[l], mask[l]);
+        uint64_t forced_moves = possible & opponent_win;
+
+        win_now[l] = Position::compute_winning_position(current_position[l], mask[l]) & possible;
+        if(forced_moves & (forced_moves - 1))
+            non_losing[l] = 0;
+        else
+            non_losing[l] = (forced_moves ? forced_moves : possible) & ~(opponent_win >> 1);
+    }
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+
+/**
+ * Vectorized version of Position::compute_winning_position
+ */
+__attribute__((target("avx2")))
+static inline __m256i compute_winning_position(__m256i position, __m256i mask, __m256i board_mask) {
+    const int H = Position::HEIGHT;
+
+    // vertical;
+    __m256i r = _mm256_and_si256(_mm256_and_si256(_mm256_slli_epi64(position, 1), _mm256_slli_epi64(position, 2)),
+                                 _mm256_slli_epi64(position, 3));
+
+    // horizontal and both diagonals share the same shift cascade
+#define ALIGN_DIRECTION(S) { \
+        __m256i p = _mm256_and_si256(_mm256_slli_epi64(position, (S)), _mm256_slli_epi64(position, 2 * (S))); \
+        r = _mm256_or_si256(r, _mm256_and_si256(p, _mm256_slli_epi64(position, 3 * (S)))); \
+        r = _mm256_or_si256(r, _mm256_and_si256(p, _mm256_srli_epi64(position, (S)))); \
+        p = _mm256_and_si256(_mm256_srli_epi64(position, (S)), _mm256_srli_epi64(position, 2 * (S))); \
+        r = _mm256_or_si256(r, _mm256_and_si256(p, _mm256_slli_epi64(position, (S)))); \
+        r = _mm256_or_si256(r, _mm256_and_si256(p, _mm256_srli_epi64(position, 3 * (S)))); \
+    }
+    ALIGN_DIRECTION(H + 1) // horizontal
+    ALIGN_DIRECTION(H)     // diagonal 1
+    ALIGN_DIRECTION(H + 2) // diagonal 2
+#undef ALIGN_DIRECTION
+
+    return _mm256_and_si256(r, _mm256_xor_si256(board_mask, mask));
+}
+
+__attribute__((target("avx2")))
+void BatchPlayout::evaluate_avx2() {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi64x(1);
+    const __m256i bottom_mask = _mm256_set1_epi64x(Position::bottom_mask);
+    const __m256i board_mask = _mm256_set1_epi64x(Position::board_mask);
+
+    for(int l = 0; l < LANES; l += 4) { // 4 lanes per register
+        __m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(current_position + l));
+        __m256i played = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(mask + l));
+
+        __m256i possible = _mm256_and_si256(_mm256_add_epi64(played, bottom_mask), board_mask);
+        __m256i win = compute_winning_position(current, played, board_mask);
+        __m256i opponent_win = compute_winning_position(_mm256_xor_si256(current, played), played, board_mask);
+        __m256i forced_moves = _mm256_and_si256(possible, opponent_win);
+
+        __m256i no_forced = _mm256_cmpeq_epi64(forced_moves, zero);
+        __m256i single_forced = _mm256_cmpeq_epi64(_mm256_and_si256(forced_moves, _mm256_sub_epi64(forced_moves, one)), zero);
+        __m256i candidates = _mm256_blendv_epi8(forced_moves, possible, no_forced);
+        __m256i result = _mm256_andnot_si256(_mm256_srli_epi64(opponent_win, 1), candidates);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(win_now + l), _mm256_and_si256(win, possible));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(non_losing + l), _mm256_and_si256(result, single_forced));
+    }
+}
+
+void BatchPlayout::evaluate() {
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    if(avx2) evaluate_avx2();
+    else evaluate_scalar();
+}
+
+#else
+
+void BatchPlayout::evaluate() {
+    evaluate_scalar();
+}
+
+#endif
+
+uint64_t BatchPlayout::randomMove(int lane, uint64_t moves) {
+    // xorshift64
+    uint64_t &r = rng[lane];
+    r ^= r << 13;
+    r ^= r >> 7;
+    r ^= r << 17;
+
+    unsigned int count = 0;
+    for(uint64_t m = moves; m; m &= m - 1) count++;
+
+    for(unsigned int k = ((r >> 32) * count) >> 32; k--;) moves &= moves - 1; // drop the k lowest moves, k uniform in [0, count)
+    return moves & (~moves + 1); // keep the lowest remaining one
+}
+
+BatchPlayout::Result BatchPlayout::run(const Position &P, unsigned int games) {
+    Result result{0, 0, 0};
+    bool active[LANES];
+    unsigned int started = 0;
+
+    for(int l = 0; l < LANES; l++) {
+        current_position[l] = P.current_position;
+        mask[l] = P.mask;
+        moves[l] = P.moves;
+        active[l] = started < games;
+        if(active[l]) started++;
+    }
+
+    unsigned int running = started;
+    while(running) {
+        evaluate();
+
+        for(int l = 0; l < LANES; l++) {
+            if(!active[l]) continue;
+
+            const bool same_player = (moves[l] - P.moves) % 2 == 0; // the player to move is the initial one
+            bool over = true;
+            if(moves[l] >= Position::WIDTH * Position::HEIGHT) result.draws++;
+            else if(win_now[l]) same_player ? result.wins++ : result.losses++;
+            else if(!non_losing[l]) same_player ? result.losses++ : result.wins++;
+            else over = false;
+
+            if(!over) { // same as Position::play
+                current_position[l] ^= mask[l];
+                mask[l] |= randomMove(l, non_losing[l]);
+                moves[l]++;
+            } else if(started < games) { // restart the lane
+                current_position[l] = P.current_position;
+                mask[l] = P.mask;
+                moves[l] = P.moves;
+                started++;
+            } else {
+                active[l] = false;
+                running--;
+            }
+        }
+    }
+
+    return result;
+}
+
+BatchPlayout::BatchPlayout(uint64_t seed) {
+    for(int l = 0; l < LANES; l++) {
+        rng[l] = (seed + l * UINT64_C(0x9E3779B97F4A7C15)) | 1;
+        current_position[l] = mask[l] = 0;
+        moves[l] = 0;
+    }
+}
+
+} // namespace Connect4
+} // namespace GameSolver
@@ -0,0 +1,69 @@
+#ifndef BATCH_PLAYOUT_HPP
+#define BATCH_PLAYOUT_HPP
+
+#include <cstdint>
+
+#include "Position.hpp"
+
+namespace GameSolver {
+namespace Connect4 {
+
+/**
+ * Play random games from a position, LANES games at a time in lockstep.
+ *
+ * Each step evaluates the winning spots and the non losing moves of all the lanes at once,
+ * with AVX2 when the cpu supports it (two registers of 4 x 64 bits lanes, interleaved),
+ * with plain code otherwise.
+ * Only the choice of the random move is done lane by lane.
+ * A lane is restarted from the initial position as soon as its game is over,
+ * so all the lanes keep working until the requested number of games is reached.
+ *
+ * Random games follow the same rules as the MCTS playouts:
+ * an immediate win is always taken and losing moves are never played.
+ */
+class BatchPlayout {
+public:
+    static const int LANES = 8;
+
+    struct Result {
+        unsigned int wins;   // games won by the player to move in the initial position
+        unsigned int draws;
+        unsigned int losses;
+    };
+
+    /**
+     * Play random games
+     * @param P: the initial position, nobody should already have won
+     * @param games: number of games to play
+     */
+    Result run(const Position &P, unsigned int games);
+
+    explicit BatchPlayout(uint64_t seed);
+
+private:
+    uint64_t rng[LANES]; // xorshift state of each lane
+
+    // state of the games, one per lane
+    uint64_t current_position[LANES];
+    uint64_t mask[LANES];
+    unsigned int moves[LANES];
+
+    // output of a step
+    uint64_t win_now[LANES];     // winning moves of the player to move
+    uint64_t non_losing[LANES];  // non losing moves of the player to move
+
+    /**
+     * Compute win_now and non_losing for all the lanes
+     */
+    void evaluate();
+    void evaluate_scalar();
+#if defined(__GNUC__) && defined(__x86_64__)
+    __attribute__((target("avx2"))) void evaluate_avx2();
+#endif
+
+    uint64_t randomMove(int lane, uint64_t moves);
+};
+
+} // namespace Connect4
+} // namespace GameSolver
+#endif
@@ -0,0 +1,135 @@
+#ifndef EVALUATOR_HPP
+#define EVALUATOR_HPP
+
+#include <cstdint>
+
+#include "Position.hpp"
+#include "EvaluatorWeights.hpp"
+
+namespace GameSolver {
+namespace Connect4 {
+
+/**
+ * Static evaluation of the positions reached at the horizon of a depth limited search.
+ *
+ * The features are, for the player to move then for the opponent:
+ * - for k from 1 to FOUR - 1, the number of winning lines (the windows of FOUR aligned cells)
+ *   holding k stones of the player and none of the opponent, mixed lines are dead and not counted
+ * - the number of winning cells (empty cells completing a line) of the player on the rows of its parity,
+ *   the even rows (0-based) for the first player and the odd rows for the second one, then on the other rows
+ *
+ * The features are computed on the raw bitboards, all the lines of a direction at once,
+ * so that the evaluation only costs at the horizon and nothing to the exact searches.
+ * The weights are trained offline (see training.hpp) and stored in EvaluatorWeights.hpp,
+ * every position is evaluated 0 for a board without trained weights.
+ */
+template<class position_t>
+class BasicEvaluator {
+public:
+    typedef typename position_t::bitboard_t bitboard_t;
+    typedef EvaluatorWeights<position_t::WIDTH, position_t::HEIGHT, position_t::FOUR> weights_t;
+
+    static const int FEATURES = weights_t::FEATURES;
+    static_assert(FEATURES == 2 * (position_t::FOUR - 1) + 4, "Weights do not match the features");
+    static_assert(position_t::FOUR < 8, "Stones of a line are counted on 3 bits");
+
+    /**
+     * Highest evaluation: any proven win or loss found before the horizon scores above it.
+     */
+    static const int MAX_EVALUATION = 3;
+
+    /**
+     * Compute the features of a position.
+     * @param P: a position, nobody should already have won
+     * @param features: FEATURES values, in the order documented above
+     */
+    static void features(const position_t &P, int features[]) {
+        const bitboard_t player = P.current_position;
+        const bitboard_t opponent = P.current_position ^ P.mask;
+        lines(player, opponent, features);
+        lines(opponent, player, features + position_t::FOUR - 1);
+
+        const bitboard_t parity = (P.nbMoves() & 1) ? odd_rows : even_rows; // rows of the player to move
+        const bitboard_t player_wins = P.current_wins;
+        const bitboard_t opponent_wins = P.opponent_wins;
+        features[2 * (position_t::FOUR - 1)] = popcount(player_wins & parity);
+        features[2 * (position_t::FOUR - 1) + 1] = popcount(player_wins & ~parity);
+        features[2 * (position_t::FOUR - 1) + 2] = popcount(opponent_wins & ~parity);
+        features[2 * (position_t::FOUR - 1) + 3] = popcount(opponent_wins & parity);
+    }
+
+    /**
+     * @return the weighted sum of the features, in 1/weights_t::UNIT of the logit of the winning chance
+     * of the player to move.
+     */
+    static int raw(const position_t &P) {
+        int f[FEATURES];
+        features(P, f);
+        int sum = weights_t::weight(FEATURES); // bias
+        for(int i = 0; i < FEATURES; i++) sum += weights_t::weight(i) * f[i];
+        return sum;
+    }
+
+    /**
+     * @return the evaluation of a position for the player to move, between -MAX_EVALUATION and MAX_EVALUATION,
+     * a step being weights_t::STEP units of raw.
+     */
+    static int evaluate(const position_t &P) {
+        if(!weights_t::TRAINED) return 0;
+
+        const int value = raw(P) / weights_t::STEP;
+        return value > MAX_EVALUATION ? MAX_EVALUATION : value < -MAX_EVALUATION ? -MAX_EVALUATION : value;
+    }
+
+private:
+    static const bitboard_t even_rows = position_t::bottom_mask * (position_t::column_mask(0) & ~bitboard_t(0) / 3);
+    static const bitboard_t odd_rows = position_t::bottom_mask * (position_t::column_mask(0) & ~bitboard_t(0) / 3 * 2);
+
+    /**
+     * Count the lines holding 1 to FOUR - 1 stones of a player and none of the other one.
+     */
+    static void lines(bitboard_t player, bitboard_t other, int counts[]) {
+        for(int k = 0; k < position_t::FOUR - 1; k++) counts[k] = 0;
+        direction<1>(player, other, counts);                         // vertical
+        direction<position_t::HEIGHT + 1>(player, other, counts);   // horizontal
+        direction<position_t::HEIGHT>(player, other, counts);       // diagonal 1
+        direction<position_t::HEIGHT + 2>(player, other, counts);   // diagonal 2
+    }
+
+    /**
+     * Count the lines of a direction, the distance between two neighbour cells being S.
+     * Each line is identified by its first cell, its stones are added with a bit sliced counter.
+     */
+    template<int S>
+    static void direction(bitboard_t player, bitboard_t other, int counts[]) {
+        bitboard_t open = position_t::board_mask; // first cells of the lines within the board without stone of other
+        bitboard_t bit0 = 0, bit1 = 0, bit2 = 0;  // number of stones of player in each line
+        for(int i = 0; i < position_t::FOUR; i++) {
+            open &= (position_t::board_mask & ~other) >> (i * S);
+            const bitboard_t stones = player >> (i * S);
+            const bitboard_t carry0 = bit0 & stones;
+            bit0 ^= stones;
+            const bitboard_t carry1 = bit1 & carry0;
+            bit1 ^= carry0;
+            bit2 ^= carry1;
+        }
+        for(int k = 1; k < position_t::FOUR; k++)
+            counts[k - 1] += popcount(open & (k & 1 ? bit0 : ~bit0) & (k & 2 ? bit1 : ~bit1) & (k & 4 ? bit2 : ~bit2));
+    }
+
+    static int popcount(uint64_t m) {
+        return __builtin_popcountll(m);
+    }
+
+#ifdef __SIZEOF_INT128__
+    static int popcount(uint128_t m) {
+        return __builtin_popcountll(uint64_t(m)) + __builtin_popcountll(uint64_t(m >> 64));
+    }
+#endif
+};
+
+typedef BasicEvaluator<Position> Evaluator;
+
+} // namespace Connect4
+} // namespace GameSolver
+#endif
@@ -0,0 +1,44 @@
+#ifndef EVALUATOR_WEIGHTS_HPP
+#define EVALUATOR_WEIGHTS_HPP
+
+#include <cstdint>
+
+namespace GameSolver {
+namespace Connect4 {
+
+/**
+ * Weights of the features of Evaluator, in 1/UNIT of logit, the last one being the bias.
+ * The evaluation grows by one every STEP units.
+ * No weights are trained for this game: every position is evaluated 0.
+ */
+template<int W, int H, int N>
+struct EvaluatorWeights {
+    static const bool TRAINED = false;
+    static const int FEATURES = 2 * (N - 1) + 4;
+    static const int UNIT = 16;
+    static const int STEP = 16;
+
+    static int weight(int) {
+        return 0;
+    }
+};
+
+/**
+ * Weights of the classic game, generated by training.hpp from 153678 positions, do not edit.
+ */
+template<>
+struct EvaluatorWeights<7, 6, 4> {
+    static const bool TRAINED = true;
+    static const int FEATURES = 10;
+    static const int UNIT = 16;
+    static const int STEP = 16;
+
+    static int weight(int feature) {
+        static constexpr int16_t weights[FEATURES + 1] = {4, 8, 2, -4, -7, -5, 9, 1, -18, -8, 23};
+        return weights[feature];
+    }
+};
+
+} // namespace Connect4
+} // namespace GameSolver
+#endif
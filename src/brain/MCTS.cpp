@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib> // for std::rand()
+#include <thread>
+
+#include "MCTS.hpp"
+#include "MoveChooser.hpp"
+
+namespace GameSolver {
+namespace Connect4 {
+
+int8_t MCTS::outcome(const Position &P, uint64_t &moves) {
+    if(P.nbMoves() >= Position::WIDTH * Position::HEIGHT) // board full
+        return DRAW;
+
+    if(P.canWinNext())
+        return WIN;
+
+    moves = P.possibleNonLosingMoves();
+    if(moves == 0) // opponent wins next move whatever we play
+        return LOSS;
+
+    return ONGOING;
+}
+
+uint64_t MCTS::Tree::randomMove(uint64_t moves) {
+    // xorshift64
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+
+    unsigned int count = 0;
+    for(uint64_t m = moves; m; m &= m - 1) count++;
+
+    for(unsigned int k = rng % count; k--;) moves &= moves - 1; // drop the k lowest moves
+    return moves & (~moves + 1);                                 // keep the lowest remaining one
+}
+
+float MCTS::Tree::playout(Position P) {
+    bool same_player = true; // is the player to move the one to move at the start of the playout
+    for(;;) {
+        uint64_t moves;
+        int8_t o = outcome(P, moves);
+        if(o != ONGOING)
+            return same_player ? reward(o) : 1.0f - reward(o);
+
+        P.play(randomMove(moves));
+        same_player = !same_player;
+    }
+}
+
+void MCTS::Tree::expand(uint32_t index, uint64_t moves) {
+    uint32_t first = arena.size();
+    for(; moves; moves &= moves - 1)
+        arena.push_back(Node{moves & (~moves + 1), 0, 0, ONGOING, 0, 0.0f});
+
+    arena[index].firstChild = first;
+    arena[index].nbChildren = arena.size() - first;
+}
+
+uint32_t MCTS::Tree::select(const Node &node, double exploration) const {
+    const double log_visits = std::log(double(node.visits));
+    uint32_t best = node.firstChild;
+    double best_value = -1;
+    for(uint32_t i = node.firstChild; i < node.firstChild + node.nbChildren; i++) {
+        const Node &child = arena[i];
+        if(child.visits == 0) return i; // always try every child once
+
+        double value = child.reward / child.visits + exploration * std::sqrt(log_visits / child.visits);
+        if(value > best_value) {
+            best_value = value;
+            best = i;
+        }
+    }
+    return best;
+}
+
+void MCTS::Tree::search(unsigned int playouts, double exploration, bool batch) {
+    const size_t max_nodes = arena.capacity();
+    std::vector<uint32_t> path;
+    path.reserve(Position::WIDTH * Position::HEIGHT + 1);
+
+    while(playouts) {
+        Position P(root);
+        uint32_t index = 0;
+        path.clear();
+        path.push_back(index);
+
+        float r;                // sum of the rewards for the player to move in P
+        unsigned int games = 1; // number of simulated games
+        for(;;) {
+            if(arena[index].outcome != ONGOING) { // terminal node, nothing to simulate
+                r = reward(arena[index].outcome);
+                break;
+            }
+
+            if(arena[index].firstChild == 0) {
+                uint64_t moves;
+                int8_t o = outcome(P, moves);
+                if(o != ONGOING) {
+                    arena[index].outcome = o;
+                    r = reward(o);
+                    break;
+                }
+
+                // expand a leaf on its second visit only, and as long as the arena is not full
+                if(arena[index].visits == 0 || arena.size() + Position::WIDTH > max_nodes) {
+                    if(batch) {
+                        BatchPlayout::Result result = batchPlayout.run(P, BatchPlayout::LANES);
+                        games = BatchPlayout::LANES;
+                        r = result.wins + 0.5f * result.draws;
+                    } else {
+                        r = playout(P);
+                    }
+                    break;
+                }
+                expand(index, moves);
+            }
+
+            index = select(arena[index], exploration);
+            P.play(arena[index].move);
+            path.push_back(index);
+        }
+
+        // a node stores rewards for the player who played its move
+        float value = games - r;
+        for(size_t i = path.size(); i--;) {
+            Node &node = arena[path[i]];
+            node.visits += games;
+            node.reward += value;
+            value = games - value;
+        }
+        playouts -= std::min(games, playouts);
+    }
+}
+
+void MCTS::Tree::reroot(uint32_t index) {
+    std::vector<Node> tree;
+    std::vector<uint32_t> origin; // index in the old arena of each node of the new one
+    tree.reserve(arena.capacity());
+    origin.reserve(arena.size());
+
+    tree.push_back(arena[index]);
+    origin.push_back(index);
+    for(uint32_t i = 0; i < tree.size(); i++) { // breadth first copy, keeps the children contiguous
+        const Node &old = arena[origin[i]];
+        if(old.firstChild) {
+            tree[i].firstChild = tree.size();
+            for(uint32_t c = old.firstChild; c < old.firstChild + old.nbChildren; c++) {
+                tree.push_back(arena[c]);
+                origin.push_back(c);
+            }
+        }
+    }
+
+    arena.swap(tree);
+}
+
+void MCTS::Tree::setRoot(const Position &P, const Budget &budget) {
+    if(!arena.empty()) {
+        if(root.key() == P.key() && root.nbMoves() == P.nbMoves())
+            return;
+
+        for(uint32_t c = arena[0].firstChild; c && c < arena[0].firstChild + arena[0].nbChildren; c++) {
+            Position P2(root);
+            P2.play(arena[c].move);
+            if(P2.key() == P.key() && P2.nbMoves() == P.nbMoves()) {
+                reroot(c);
+                root = P;
+                return;
+            }
+
+            for(uint32_t g = arena[c].firstChild; g && g < arena[c].firstChild + arena[c].nbChildren; g++) {
+                Position P3(P2);
+                P3.play(arena[g].move);
+                if(P3.key() == P.key() && P3.nbMoves() == P.nbMoves()) {
+                    reroot(g);
+                    root = P;
+                    return;
+                }
+            }
+        }
+    }
+
+    arena.clear();
+    arena.reserve(budget.nodes);
+    arena.push_back(Node{0, 0, 0, ONGOING, 0, 0.0f});
+    root = P;
+}
+
+void MCTS::Tree::addRootVisits(uint64_t visits[Position::WIDTH]) const {
+    for(uint32_t c = arena[0].firstChild; c && c < arena[0].firstChild + arena[0].nbChildren; c++)
+        visits[Position::moveColumn(arena[c].move)] += arena[c].visits;
+}
+
+int MCTS::getBestMove(const Position &P) {
+    if(P.possible() == 0) {
+        return -1;
+    }
+
+    for(int col = 0; col < Position::WIDTH; col++) // play an immediate win without searching
+        if(P.canPlay(col) && P.isWinningMove(col))
+            return col;
+
+    uint64_t moves = P.possibleNonLosingMoves();
+    if(moves == 0) // every move loses, play whatever
+        moves = P.possible();
+    if(!(moves & (moves - 1))) // a single (forced) move
+        return Position::moveColumn(moves);
+
+    for(Tree &tree : trees)
+        tree.setRoot(P, budget);
+
+    const unsigned int playouts = budget.playouts / trees.size() + 1;
+    if(trees.size() == 1) {
+        trees[0].search(playouts, budget.exploration, budget.batch);
+    } else {
+        std::vector<std::thread> threads;
+        for(Tree &tree : trees)
+            threads.emplace_back(&Tree::search, &tree, playouts, budget.exploration, budget.batch);
+        for(std::thread &thread : threads)
+            thread.join();
+    }
+
+    uint64_t visits[Position::WIDTH] = {0};
+    for(const Tree &tree : trees)
+        tree.addRootVisits(visits);
+
+    MoveChooser chooser;
+    for(int col = 0; col < Position::WIDTH; col++)
+        if(uint64_t move = moves & Position::column_mask(col))
+            chooser.add(move, visits[col]);
+
+    return Position::moveColumn(chooser.getBestMove());
+}
+
+void MCTS::setBudget(const Budget &budget) {
+    this->budget = budget;
+    reset();
+}
+
+void MCTS::reset() {
+    trees.clear();
+    for(unsigned int i = 0; i < budget.threads; i++)
+        trees.emplace_back(uint64_t(std::rand()) << 32 | std::rand());
+}
+
+// Constructor
+MCTS::MCTS() : budget{1000, 1 << 16, 1, 1.4, false} {
+    reset();
+}
+
+} // namespace Connect4
+} // namespace GameSolver
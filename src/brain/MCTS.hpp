@@ -0,0 +1,135 @@
+#ifndef MCTS_HPP
+#define MCTS_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "BatchPlayout.hpp"
+#include "Position.hpp"
+
+namespace GameSolver {
+namespace Connect4 {
+
+/**
+ * Monte Carlo Tree Search engine.
+ *
+ * The strength of the engine is tuned by its budget: the number of random playouts
+ * per move and the maximum number of nodes of the tree.
+ * Both are fixed, so the cost of a move is bounded whatever the position is.
+ *
+ * Leaves are evaluated with a single random game, or with a batch of games
+ * played in lockstep by BatchPlayout.
+ *
+ * The search uses root parallelism: every thread grows its own tree
+ * and the visits of the root children are summed up at the end.
+ * Trees are kept between moves, when the next position to search is found
+ * within two plies of the previous root the subtree is reused.
+ */
+class MCTS {
+public:
+
+    struct Budget {
+        unsigned int playouts;  // number of playouts per move (for all the threads)
+        unsigned int nodes;     // max number of nodes of each tree
+        unsigned int threads;   // number of threads, each one with its own tree
+        double exploration;     // UCT exploration constant
+        bool batch;             // simulate BatchPlayout::LANES games per leaf with the vectorized kernel
+    };
+
+    /**
+     * Return the best column to play.
+     * @param P: the position to search, nobody should already have won
+     * @return the 0-based index of the column to play, -1 if no move is allowed
+     */
+    int getBestMove(const Position &P);
+
+    /**
+     * Set the budget of the search, the current trees are dropped.
+     */
+    void setBudget(const Budget &budget);
+
+    /**
+     * Drop the current trees
+     */
+    void reset();
+
+    MCTS(); // Constructor
+
+private:
+
+    /**
+     * A node of the tree, stored in an arena.
+     * Children of a node are contiguous in the arena.
+     */
+    struct Node {
+        uint64_t move;        // move leading to this node
+        uint32_t firstChild;  // index of the first child in the arena, 0 if the node is not expanded
+        uint8_t nbChildren;   // number of children
+        int8_t outcome;       // ONGOING or the outcome of the game for the player to move
+        uint32_t visits;      // number of playouts through this node
+        float reward;         // sum of the rewards for the player who played move
+    };
+
+    static const int8_t ONGOING = -1;
+    static const int8_t LOSS = 0;
+    static const int8_t DRAW = 1;
+    static const int8_t WIN = 2;
+
+    /**
+     * A tree grown by a single thread.
+     * The root is always the first node of the arena.
+     */
+    class Tree {
+    public:
+        /**
+         * Move the root to the given position.
+         * The subtree is kept if the position is a child or a grandchild of the current root.
+         */
+        void setRoot(const Position &P, const Budget &budget);
+
+        /**
+         * Run the given number of playouts
+         */
+        void search(unsigned int playouts, double exploration, bool batch);
+
+        /**
+         * Add the visits of each root child to the per column counters
+         */
+        void addRootVisits(uint64_t visits[Position::WIDTH]) const;
+
+        explicit Tree(uint64_t seed) : rng{seed | 1}, batchPlayout{seed} {}
+
+    private:
+        std::vector<Node> arena;
+        Position root;
+        uint64_t rng; // xorshift state
+        BatchPlayout batchPlayout;
+
+        void reroot(uint32_t index);
+        uint32_t select(const Node &node, double exploration) const;
+        void expand(uint32_t index, uint64_t moves);
+        float playout(Position P);
+        uint64_t randomMove(uint64_t moves);
+    };
+
+    Budget budget;
+    std::vector<Tree> trees;
+
+    /**
+     * Compute the outcome of a position for the player to move
+     * @param moves: set to the non losing moves of the player if the game is not over.
+     * @return ONGOING, WIN, LOSS or DRAW
+     */
+    static int8_t outcome(const Position &P, uint64_t &moves);
+
+    /**
+     * Convert an outcome to a reward in [0, 1]
+     */
+    static float reward(int8_t outcome) {
+        return outcome * 0.5f;
+    }
+};
+
+} // namespace Connect4
+} // namespace GameSolver
+#endif
@@ -1,20 +1,23 @@
 #ifndef MOVE_HPP
 #define MOVE_HPP
 
-#include <QJsonObject>
+#include <QObject>
+#include <QMetaType>
 
+/**
+ * A cell of the board, passed by value to QML which reads its properties.
+ */
 class Move
 {
+    Q_GADGET
+    Q_PROPERTY(int column MEMBER column)
+    Q_PROPERTY(int row MEMBER row)
 public:
     int column;
     int row;
-
-    const QJsonObject toJSon() {
-        return QJsonObject{
-            {"column", column},
-            {"row", row}
-        };
-    }
 };
 
+Q_DECLARE_TYPEINFO(Move, Q_PRIMITIVE_TYPE); // small enough to be held by a QVariant without allocation
+Q_DECLARE_METATYPE(Move)
+
 #endif // MOVE_HPP
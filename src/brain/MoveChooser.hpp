@@ -34,14 +34,16 @@ namespace Connect4 {
  * then you can get the best move back.
  * If more than one move have the same score the class choose randomly one.
  */
-class MoveChooser {
+template<class position_t>
+class BasicMoveChooser {
 public:
+    typedef typename position_t::bitboard_t bitboard_t;
 
     /**
      * Add a move in the container with its score.
-     * You cannot add more than Position::WIDTH moves
+     * You cannot add more than position_t::WIDTH moves
      */
-    void add(uint64_t move, int mscore) {
+    void add(bitboard_t move, int mscore) {
         if (mscore < score) return;
 
         if (mscore > score) {
@@ -58,7 +60,7 @@ public:
      * @return the best move, if more than one move have the same score the class choose randomly one.
      * If no move is available return 0
      */
-    uint64_t getBestMove() {
+    bitboard_t getBestMove() {
         if(size) {
             static constexpr double fraction { 1.0 / (RAND_MAX + 1.0) };
             int pos = static_cast<int>(size * (std::rand() * fraction));
@@ -85,7 +87,7 @@ public:
     /**
      * Build an empty container
      */
-    MoveChooser(): size{0}, score{INT_MIN} {
+    BasicMoveChooser(): size{0}, score{INT_MIN} {
     }
 
 private:
@@ -95,9 +97,11 @@ private:
     int score;
 
     // Contains size moves with the current best score
-    uint64_t entries[Position::WIDTH];
+    bitboard_t entries[position_t::WIDTH];
 };
 
+typedef BasicMoveChooser<Position> MoveChooser;
+
 } // namespace Connect4
 } // namespace GameSolver
 #endif
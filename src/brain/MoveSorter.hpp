@@ -20,6 +20,7 @@
 #define MOVE_SORTER_HPP
 
 #include "Position.hpp"
+#include "MoveStatistics.hpp"
 
 namespace GameSolver {
 namespace Connect4 {
@@ -35,14 +36,37 @@ namespace Connect4 {
  * and also efficient if the move are pushed in approximatively increasing
  * order which can be acheived by using a simpler column ordering heuristic.
  */
-class MoveSorter {
+template<class position_t>
+class BasicMoveSorter {
 public:
+    typedef typename position_t::bitboard_t bitboard_t;
+    typedef MoveStatistics<position_t::WIDTH, position_t::HEIGHT> statistics_t;
+
+    /**
+     * Score of a move for the ordering, below (position_t::WIDTH * position_t::HEIGHT + 1) * statistics_t::SCALE:
+     * the number of winning cells the move creates (see Position::moveScore), ties broken by the rate
+     * at which the moves of the same pattern on the same cell are best moves, mined from the opening books.
+     * @param column: the column of the move
+     */
+    static int score(const position_t &P, bitboard_t move, int column) {
+        const int threats = P.moveScore(move);
+        return threats * statistics_t::SCALE + statistics_t::rate(threats, cell(move, column));
+    }
+
+    /**
+     * @return the cell of a move, column * position_t::HEIGHT + row.
+     */
+    static int cell(bitboard_t move, int column) {
+        int row = 0;
+        for(bitboard_t bit = move >> column * (position_t::HEIGHT + 1); !(bit & 1); bit >>= 1) row++;
+        return column * position_t::HEIGHT + row;
+    }
 
     /**
      * Add a move in the container with its score.
-     * You cannot add more than Position::WIDTH moves
+     * You cannot add more than position_t::WIDTH moves
      */
-    void add(uint64_t move, int score) {
+    void add(bitboard_t move, int score) {
         int pos = size++;
         for(; pos && entries[pos - 1].score > score; --pos) entries[pos] = entries[pos - 1];
         entries[pos].move = move;
@@ -54,7 +78,7 @@ public:
      * @return next remaining move with max score and remove it from the container.
      * If no more move is available return 0
      */
-    uint64_t getNext() {
+    bitboard_t getNext() {
         if(size)
             return entries[--size].move;
         else
@@ -71,7 +95,7 @@ public:
     /**
      * Build an empty container
      */
-    MoveSorter(): size{0} {
+    BasicMoveSorter(): size{0} {
     }
 
 private:
@@ -80,11 +104,13 @@ private:
 
     // Contains size moves with their score ordered by score
     struct {
-        uint64_t move;
+        bitboard_t move;
         int score;
-    } entries[Position::WIDTH];
+    } entries[position_t::WIDTH];
 };
 
+typedef BasicMoveSorter<Position> MoveSorter;
+
 } // namespace Connect4
 } // namespace GameSolver
 #endif
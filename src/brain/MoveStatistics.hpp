@@ -0,0 +1,31 @@
+#ifndef MOVE_STATISTICS_HPP
+#define MOVE_STATISTICS_HPP
+
+#include <cstdint>
+
+namespace GameSolver {
+namespace Connect4 {
+
+/**
+ * Rates at which the moves are best moves, by pattern and cell, in 1/SCALE, used by MoveSorter to break ties.
+ * The pattern of a move is the number of winning cells it creates, up to PATTERNS - 1.
+ * A cell is column * HEIGHT + row.
+ *
+ * The statistics are mined offline from the opening books by statistics.hpp,
+ * which prints a specialization of this template for the classic board.
+ * No specialization is compiled in: the statistics mined so far order worse than the center first column order
+ * of the solver, so every rate is 0 and the ordering is left to the number of winning cells and the column order.
+ */
+template<int W, int H>
+struct MoveStatistics {
+    static const int SCALE = 64;
+    static const int PATTERNS = 3;
+
+    static int rate(int, int) {
+        return 0;
+    }
+};
+
+} // namespace Connect4
+} // namespace GameSolver
+#endif
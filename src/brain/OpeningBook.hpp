@@ -82,6 +82,14 @@ public:
      */
     void clear() {
         if (T) T->reset();
+        depth = -1;
+    }
+
+    /**
+     * @return the max depth of the stored positions, -1 if the book is empty
+     */
+    int getDepth() const {
+        return depth;
     }
 
     /**
@@ -190,7 +198,8 @@ public:
         }
     }
 
-    int get(const Position &P) const {
+    template<class position_t>
+    int get(const position_t &P) const {
         if(P.nbMoves() > depth) return 0;
 
         return T ? T->get(P.key3()) : 0;
@@ -27,6 +27,7 @@
 #include <iostream>
 #include <bitset>
 #include <array>
+#include <type_traits>
 
 #include "Move.hpp"
 
@@ -39,6 +40,8 @@ namespace Connect4 {
  *
  * A binary bitboard representationis used.
  * Each column is encoded on HEIGH+1 bits.
+ * The board size is a compile time parameter, a 64 bits bitboard is used when
+ * the board fits in (7x6 is the classic game), a 128 bits bitboard otherwise (such as 8x7 or 9x7).
  *
  * Example of bit order to encode for a 7x6 board
  * .  .  .  .  .  .  .
@@ -87,27 +90,111 @@ namespace Connect4 {
  * Generate a bitmask containing one for the bottom slot of each colum
  * must be defined outside of the class definition to be available at compile time for bottom_mask
  */
-constexpr static uint64_t bottom(int width, int height) {
-    return width == 0 ? 0 : bottom(width - 1, height) | 1LL << (width - 1) * (height + 1);
+template<class bitboard_t>
+constexpr bitboard_t bottom(int width, int height) {
+    return width == 0 ? 0 : bottom<bitboard_t>(width - 1, height) | bitboard_t(1) << (width - 1) * (height + 1);
 }
 
 /**
- * Print position in human-readable form
- * @param position the position to print
+ * Bitboard type able to store a board of the given number of bits:
+ * 64 bits integer for the classic board, 128 bits integer for larger boards.
+ */
+template<bool WIDE> struct bitboard_type {
+    typedef uint64_t type;
+};
+#ifdef __SIZEOF_INT128__
+__extension__ typedef unsigned __int128 uint128_t;
+template<> struct bitboard_type<true> {
+    typedef uint128_t type;
+};
+#endif
+
+/**
+ * Shift cascades of the alignment tests, unrolled at compile time for any alignment length.
+ * A direction of the board is given by the distance S between two neighbour cells in the bitboard.
  */
-static void print64(uint64_t position);
+template<class bitboard_t, int S, int K>
+struct Line {
+    // cells having K stones in a row just before them in direction S (towards the lower bits)
+    static bitboard_t before(bitboard_t p) {
+        return Line<bitboard_t, S, K - 1>::before(p) & (p << S * K);
+    }
+
+    // cells having K stones in a row just after them in direction S (towards the higher bits)
+    static bitboard_t after(bitboard_t p) {
+        return Line<bitboard_t, S, K - 1>::after(p) & (p >> S * K);
+    }
+
+    // cells having the other N - 1 stones of an alignment around them, at most K of them before
+    template<int N>
+    static bitboard_t around(bitboard_t p) {
+        return (before(p) & Line<bitboard_t, S, N - 1 - K>::after(p)) | Line<bitboard_t, S, K - 1>::template around<N>(p);
+    }
+
+    // first cells of K consecutive stones, by doubling the length of the runs as in a 4 stones test:
+    // m = p & (p >> S); m & (m >> 2S)
+    static bitboard_t run(bitboard_t p) {
+        return K % 2 ? Line<bitboard_t, S, K - 1>::run(p) & (p >> S * (K - 1))
+                     : Line<bitboard_t, S, K / 2>::run(p) & (Line<bitboard_t, S, K / 2>::run(p) >> S * (K / 2));
+    }
+};
+
+template<class bitboard_t, int S>
+struct Line<bitboard_t, S, 0> {
+    static bitboard_t before(bitboard_t) {
+        return ~bitboard_t(0);
+    }
+
+    static bitboard_t after(bitboard_t) {
+        return ~bitboard_t(0);
+    }
+
+    template<int N>
+    static bitboard_t around(bitboard_t p) {
+        return Line<bitboard_t, S, N - 1>::after(p);
+    }
+
+    static bitboard_t run(bitboard_t) {
+        return ~bitboard_t(0);
+    }
+};
+
+template<class bitboard_t, int S>
+struct Line<bitboard_t, S, 1> {
+    static bitboard_t before(bitboard_t p) {
+        return p << S;
+    }
+
+    static bitboard_t after(bitboard_t p) {
+        return p >> S;
+    }
+
+    template<int N>
+    static bitboard_t around(bitboard_t p) {
+        return (before(p) & Line<bitboard_t, S, N - 2>::after(p)) | Line<bitboard_t, S, N - 1>::after(p);
+    }
+
+    static bitboard_t run(bitboard_t p) {
+        return p;
+    }
+};
 
-class Position {
+template<int W, int H, int N = 4>
+class BasicPosition {
 public:
 
-    static const int WIDTH = 7;  // width of the board
-    static const int HEIGHT = 6; // height of the board
-    static const int MIN_SCORE = -(WIDTH*HEIGHT) / 2 + 3;
-    static const int MAX_SCORE = (WIDTH * HEIGHT + 1) / 2 - 3;
-    static const int FOUR = 4; // how many disk align to win
+    static const int WIDTH = W;  // width of the board
+    static const int HEIGHT = H; // height of the board
+    static const int FOUR = N;   // how many disk align to win
+    static const int MIN_SCORE = -(WIDTH*HEIGHT) / 2 + FOUR - 1;
+    static const int MAX_SCORE = (WIDTH * HEIGHT + 1) / 2 - FOUR + 1;
+
+    static_assert(FOUR >= 2 && FOUR <= WIDTH && FOUR <= HEIGHT, "Alignment length must fit in the board");
 
     static_assert(WIDTH < 10, "Board's width must be less than 10");
-    static_assert(WIDTH * (HEIGHT + 1) <= 64, "Board does not fit in 64bits bitboard");
+    static_assert(WIDTH * (HEIGHT + 1) <= 128, "Board does not fit in 128bits bitboard");
+
+    typedef typename bitboard_type<(WIDTH * (HEIGHT + 1) > 64)>::type bitboard_t;
 
 
     /**
@@ -116,11 +203,46 @@ public:
      * @param move: a possible move given by its bitmap representation
      *        only one bit of the bitmap should be set to 1
      *        the move should be a valid possible move for the current player
+     *
+     * A stone only adds winning cells to its player and removes its own cell from the ones of the opponent:
+     * only the winning cells of the player making the move are computed again.
      */
-    void play(uint64_t move) {
+    void play(bitboard_t move) {
+        const bitboard_t wins = compute_winning_position(current_position | move, mask | move);
         current_position ^= mask;
         mask |= move;
         moves++;
+        current_wins = opponent_wins & ~move;
+        opponent_wins = wins;
+    }
+
+    /**
+     * Winning cells of both players: the part of a position undo() cannot compute back from the move.
+     */
+    struct Threats {
+        bitboard_t current;
+        bitboard_t opponent;
+    };
+
+    /**
+     * @return the winning cells of both players, to be saved before play() and given back to undo().
+     */
+    Threats threats() const {
+        return Threats{current_wins, opponent_wins};
+    }
+
+    /**
+     * Takes back the last played move, so that a search can play and undo its moves on a single position.
+     *
+     * @param move: the last played move given by its bitmap representation
+     * @param threats: the winning cells of the position before the move, see threats()
+     */
+    void undo(bitboard_t move, const Threats &threats) {
+        mask ^= move;
+        current_position ^= mask;
+        moves--;
+        current_wins = threats.current;
+        opponent_wins = threats.opponent;
     }
 
     /**
@@ -137,7 +259,7 @@ public:
     unsigned int playSeq(std::string seq) {
         for(unsigned int i = 0; i < seq.size(); i++) {
             int col = seq[i] - '0'; // 0-based
-            if(col < 0 || col >= Position::WIDTH || !canPlay(col) || isWinningMove(col)) return i; // invalid move
+            if(col < 0 || col >= WIDTH || !canPlay(col) || isWinningMove(col)) return i; // invalid move
             playCol(col);
         }
         return seq.size();
@@ -161,7 +283,7 @@ public:
     /**
      * @return a compact representation of a position on WIDTH*(HEIGHT+1) bits.
      */
-    uint64_t key() const {
+    bitboard_t key() const {
         return current_position + mask;
     }
 
@@ -181,14 +303,27 @@ public:
      */
     uint64_t key3() const {
         uint64_t key_forward = 0;
-        for(int i = 0; i < Position::WIDTH; i++) partialKey3(key_forward, i);  // compute key in increasing order of columns
+        for(int i = 0; i < WIDTH; i++) partialKey3(key_forward, i);  // compute key in increasing order of columns
 
         uint64_t key_reverse = 0;
-        for(int i = Position::WIDTH; i--;) partialKey3(key_reverse, i);  // compute key in decreasing order of columns
+        for(int i = WIDTH; i--;) partialKey3(key_reverse, i);  // compute key in decreasing order of columns
 
         return key_forward < key_reverse ? key_forward / 3 : key_reverse / 3; // take the smallest key and divide per 3 as the last base3 digit is always 0
     }
 
+    /**
+     * Indicates whether the position is its own mirror image (left-right symmetric),
+     * the mirrored columns then lead to mirror-identical positions.
+     */
+    bool isSymmetric() const {
+        for(int i = 0; i < WIDTH / 2; i++) {
+            const int shift = (WIDTH - 1 - 2 * i) * (HEIGHT + 1); // distance between column i and its mirror
+            if(((mask >> shift) ^ mask) & column_mask(i)) return false;
+            if(((current_position >> shift) ^ current_position) & column_mask(i)) return false;
+        }
+        return true;
+    }
+
     /**
      * Return a bitmap of all the possible next moves the do not lose in one turn.
      * A losing move is a move leaving the possibility for the opponent to win directly.
@@ -197,11 +332,11 @@ public:
      * If you have a winning move, this function can miss it and prefer to prevent the opponent
      * to make an alignment.
      */
-    uint64_t possibleNonLosingMoves() const {
+    bitboard_t possibleNonLosingMoves() const {
         assert(!canWinNext());
-        uint64_t possible_mask = possible();
-        uint64_t opponent_win = opponent_winning_position();
-        uint64_t forced_moves = possible_mask & opponent_win;
+        bitboard_t possible_mask = possible();
+        bitboard_t opponent_win = opponent_winning_position();
+        bitboard_t forced_moves = possible_mask & opponent_win;
         if(forced_moves) {
             if(forced_moves & (forced_moves - 1)) // check if there is more than one forced move
                 return 0;                           // the opponnent has two winning moves and you cannot stop him
@@ -214,7 +349,7 @@ public:
      * Bitmap of the next possible valid moves for the current player
      * Including losing moves.
      */
-    uint64_t possible() const {
+    bitboard_t possible() const {
         return (mask + bottom_mask) & board_mask;
     }
 
@@ -226,14 +361,14 @@ public:
      * The score we are using is the number of winning spots
      * the current player has after playing the move.
      */
-    int moveScore(uint64_t move) const {
+    int moveScore(bitboard_t move) const {
         return popcount(compute_winning_position(current_position | move, mask));
     }
 
     /**
      * Default constructor, build an empty position.
      */
-    Position() : current_position{0}, mask{0}, moves{0} {}
+    BasicPosition() : current_position{0}, mask{0}, moves{0}, current_wins{0}, opponent_wins{0} {}
 
     /**
      * Indicates whether a column is playable.
@@ -251,9 +386,11 @@ public:
      * @param col: 0-based index of a playable column.
      */
     int playCol(int col) {
-        uint64_t move = (mask + bottom_mask_col(col)) & column_mask(col);
+        bitboard_t move = (mask + bottom_mask_col(col)) & column_mask(col);
         play(move);
-        return log2((move >> (HEIGHT+1) * col));
+        int row = 0;
+        for(move >>= (HEIGHT+1) * col; move > 1; move >>= 1) row++;
+        return row;
     }
 
     /**
@@ -304,15 +441,15 @@ public:
     std::array<Move, FOUR> getWinningPosition() {
         std::array<Move, FOUR> arr;
 
-        std::bitset<64> bs = std::bitset<64>(current_position ^ mask); // last player position
+        const bitboard_t last = current_position ^ mask; // last player position
 
         // Check orizzontal
         for(int r = 0; r < HEIGHT; r++) {
             for(int c = 0; c <= WIDTH - FOUR; c++) {
                 bool ok = true;
                 for(int p = 0; p < FOUR; p++) {
-                    int m = r + c  * WIDTH + p  * WIDTH;
-                    ok &= bs[m] == 1;
+                    int m = r + c * (HEIGHT + 1) + p * (HEIGHT + 1);
+                    ok &= ((last >> m) & 1) == 1;
                 }
                 if (ok) {
                     for(int p = 0; p < FOUR; p++) {
@@ -327,8 +464,8 @@ public:
             for(int r = 0; r <= HEIGHT - FOUR; r++) {
                 bool ok = true;
                 for(int p = 0; p < FOUR; p++) {
-                    int m = c * WIDTH + r + p;
-                    ok &= bs[m] == 1;
+                    int m = c * (HEIGHT + 1) + r + p;
+                    ok &= ((last >> m) & 1) == 1;
                 }
                 if (ok) {
                     for(int p = 0; p < FOUR; p++) {
@@ -343,9 +480,9 @@ public:
             for(int c = 0; c <= WIDTH - FOUR; c++) {
                 bool ok = true;
                 for(int p = 0; p < FOUR; p++) {
-                    int m = c * WIDTH + r + p * WIDTH + p;
+                    int m = c * (HEIGHT + 1) + r + p * (HEIGHT + 1) + p;
                     assert(m < WIDTH * (HEIGHT + 1));
-                    ok &= bs[m] == 1;
+                    ok &= ((last >> m) & 1) == 1;
                 }
                 if (ok) {
                     for(int p = 0; p < FOUR; p++) {
@@ -356,13 +493,13 @@ public:
         }
 
         // Check diagonal 2
-        for(int r = HEIGHT - 1; r > HEIGHT - FOUR; r--) {
+        for(int r = HEIGHT - 1; r >= FOUR - 1; r--) {
             for(int c = 0; c <= WIDTH - FOUR; c++) {
                 bool ok = true;
                 for(int p = 0; p < FOUR; p++) {
-                    int m = c * WIDTH + r + p * WIDTH - p;
+                    int m = c * (HEIGHT + 1) + r + p * (HEIGHT + 1) - p;
                     assert(m < WIDTH * (HEIGHT + 1));
-                    ok &= bs[m] == 1;
+                    ok &= ((last >> m) & 1) == 1;
                 }
                 if (ok) {
                     for(int p = 0; p < FOUR; p++) {
@@ -376,15 +513,21 @@ public:
     }
 
 private:
-    uint64_t current_position; // bitmap of the current_player stones
-    uint64_t mask;             // bitmap of all the already palyed spots
+    friend class BatchPlayout; // plays many positions at once on the raw bitboards
+    template<class position_t> friend class BasicThreatOracle; // proves bounds from the raw bitboards
+    template<class position_t> friend class BasicEvaluator;    // counts the lines on the raw bitboards
+
+    bitboard_t current_position; // bitmap of the current_player stones
+    bitboard_t mask;             // bitmap of all the already palyed spots
     unsigned int moves;        // number of moves played since the beinning of the game.
+    bitboard_t current_wins;     // bitmap of the winning free spots of the current player, maintained by play()
+    bitboard_t opponent_wins;    // bitmap of the winning free spots of the opponent, maintained by play()
 
     /**
      * Compute a partial base 3 key for a given column
      */
     void partialKey3(uint64_t &key, int col) const {
-        for(uint64_t pos = UINT64_C(1) << (col * (Position::HEIGHT + 1)); pos & mask; pos <<= 1) {
+        for(bitboard_t pos = bitboard_t(1) << (col * (HEIGHT + 1)); pos & mask; pos <<= 1) {
             key *= 3;
             if(pos & current_position) key += 1;
             else key += 2;
@@ -395,21 +538,21 @@ private:
     /**
      * Return a bitmask of the possible winning positions for the current player
      */
-    uint64_t winning_position() const {
-        return compute_winning_position(current_position, mask);
+    bitboard_t winning_position() const {
+        return current_wins;
     }
 
     /**
      * Return a bitmask of the possible winning positions for the opponent
      */
-    uint64_t opponent_winning_position() const {
-        return compute_winning_position(current_position ^ mask, mask);
+    bitboard_t opponent_winning_position() const {
+        return opponent_wins;
     }
 
     /**
      * counts number of bit set to one in a 64bits integer
      */
-    static unsigned int popcount(uint64_t m) {
+    static unsigned int popcount(bitboard_t m) {
         unsigned int c = 0;
         for(c = 0; m; c++) m &= m - 1;
         return c;
@@ -421,33 +564,18 @@ private:
      *
      * @return a bitmap of all the winning free spots making an alignment
      */
-    static uint64_t compute_winning_position(uint64_t position, uint64_t mask) {
+    static bitboard_t compute_winning_position(bitboard_t position, bitboard_t mask) {
         // vertical;
-        uint64_t r = (position << 1) & (position << 2) & (position << 3);
+        bitboard_t r = Line<bitboard_t, 1, FOUR - 1>::before(position);
 
         //horizontal
-        uint64_t p = (position << (HEIGHT + 1)) & (position << 2 * (HEIGHT + 1));
-        r |= p & (position << 3 * (HEIGHT + 1));
-        r |= p & (position >> (HEIGHT + 1));
-        p = (position >> (HEIGHT + 1)) & (position >> 2 * (HEIGHT + 1));
-        r |= p & (position << (HEIGHT + 1));
-        r |= p & (position >> 3 * (HEIGHT + 1));
+        r |= Line<bitboard_t, HEIGHT + 1, FOUR - 1>::template around<FOUR>(position);
 
         //diagonal 1
-        p = (position << HEIGHT) & (position << 2 * HEIGHT);
-        r |= p & (position << 3 * HEIGHT);
-        r |= p & (position >> HEIGHT);
-        p = (position >> HEIGHT) & (position >> 2 * HEIGHT);
-        r |= p & (position << HEIGHT);
-        r |= p & (position >> 3 * HEIGHT);
+        r |= Line<bitboard_t, HEIGHT, FOUR - 1>::template around<FOUR>(position);
 
         //diagonal 2
-        p = (position << (HEIGHT + 2)) & (position << 2 * (HEIGHT + 2));
-        r |= p & (position << 3 * (HEIGHT + 2));
-        r |= p & (position >> (HEIGHT + 2));
-        p = (position >> (HEIGHT + 2)) & (position >> 2 * (HEIGHT + 2));
-        r |= p & (position << (HEIGHT + 2));
-        r |= p & (position >> 3 * (HEIGHT + 2));
+        r |= Line<bitboard_t, HEIGHT + 2, FOUR - 1>::template around<FOUR>(position);
 
         return r & (board_mask ^ mask);
     }
@@ -455,49 +583,61 @@ private:
     /**
      * Test an alignment for current player (identified by one in the bitboard pos)
      * @param a bitboard position of a player's cells.
-     * @return true if the player has a 4-alignment.
+     * @return true if the player has a FOUR-alignment.
      */
-    static bool alignment(uint64_t pos) {
+    static bool alignment(bitboard_t pos) {
         // horizontal
-        uint64_t m = pos & (pos >> (HEIGHT+1));
-        if(m & (m >> (2*(HEIGHT+1)))) return true;
+        if(Line<bitboard_t, HEIGHT + 1, FOUR>::run(pos)) return true;
 
         // diagonal 1
-        m = pos & (pos >> HEIGHT);
-        if(m & (m >> (2*HEIGHT))) return true;
+        if(Line<bitboard_t, HEIGHT, FOUR>::run(pos)) return true;
 
         // diagonal 2
-        m = pos & (pos >> (HEIGHT+2));
-        if(m & (m >> (2*(HEIGHT+2)))) return true;
+        if(Line<bitboard_t, HEIGHT + 2, FOUR>::run(pos)) return true;
 
         // vertical;
-        m = pos & (pos >> 1);
-        if(m & (m >> 2)) return true;
+        if(Line<bitboard_t, 1, FOUR>::run(pos)) return true;
 
         return false;
     }
 
     // Static bitmaps
-    const static uint64_t bottom_mask = bottom(WIDTH, HEIGHT);
-    const static uint64_t board_mask = bottom_mask * ((1LL << HEIGHT) - 1);
+    const static bitboard_t bottom_mask = bottom<bitboard_t>(WIDTH, HEIGHT);
+    const static bitboard_t board_mask = bottom_mask * ((bitboard_t(1) << HEIGHT) - 1);
 
     // return a bitmask containg a single 1 corresponding to the top cel of a given column
-    static constexpr uint64_t top_mask_col(int col) {
-        return UINT64_C(1) << ((HEIGHT - 1) + col * (HEIGHT + 1));
+    static constexpr bitboard_t top_mask_col(int col) {
+        return bitboard_t(1) << ((HEIGHT - 1) + col * (HEIGHT + 1));
     }
 
     // return a bitmask containg a single 1 corresponding to the bottom cell of a given column
-    static constexpr uint64_t bottom_mask_col(int col) {
-        return UINT64_C(1) << col * (HEIGHT + 1);
+    static constexpr bitboard_t bottom_mask_col(int col) {
+        return bitboard_t(1) << col * (HEIGHT + 1);
     }
 
 public:
     // return a bitmask 1 on all the cells of a given column
-    static constexpr uint64_t column_mask(int col) {
-        return ((UINT64_C(1) << HEIGHT) - 1) << col * (HEIGHT + 1);
+    static constexpr bitboard_t column_mask(int col) {
+        return ((bitboard_t(1) << HEIGHT) - 1) << col * (HEIGHT + 1);
+    }
+
+    // return the 0-based index of the column of a move given by its bitmap representation
+    static int moveColumn(bitboard_t move) {
+        for(int i = WIDTH; i--;) {
+            if(move & column_mask(i)) {
+                return i;
+            }
+        }
+        assert(false && "Unable to find a column for the move"); // I should never be here
+        return -1;
     }
 };
 
+/**
+ * The classic 7x6 board, 4 disks to align
+ */
+typedef BasicPosition<7, 6, 4> Position;
+
 /**
  * Print position in human-readable form
  * @param position the position to print
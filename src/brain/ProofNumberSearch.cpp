@@ -0,0 +1,125 @@
+#include <algorithm>
+
+#include "ProofNumberSearch.hpp"
+#include "ThreatOracle.hpp"
+
+namespace GameSolver {
+namespace Connect4 {
+
+const uint32_t ProofNumberSearch::INF; // bound to the references of std::min
+
+void ProofNumberSearch::evaluate(Node &node, const Position &P, uint64_t &moves) {
+    moves = 0;
+    bool win; // the root player wins
+    if(P.nbMoves() >= Position::WIDTH * Position::HEIGHT) // draw
+        win = false;
+    else if(P.canWinNext()) // the player to move wins
+        win = node.orNode;
+    else if((moves = P.possibleNonLosingMoves()) == 0) // the player to move loses
+        win = !node.orNode;
+    else if(ThreatOracle::upperBound(P) <= (node.orNode ? 0 : -1)) // root player cannot win, or opponent loses
+        win = !node.orNode;
+    else { // unknown
+        node.pn = 1;
+        node.dn = 1;
+        return;
+    }
+
+    moves = 0;
+    node.pn = win ? 0 : INF;
+    node.dn = win ? INF : 0;
+}
+
+void ProofNumberSearch::expand(uint32_t index, const Position &P) {
+    uint64_t moves;
+    evaluate(arena[index], P, moves);
+    if(moves == 0) return; // solved leaf
+
+    const uint32_t first = arena.size();
+    const bool orNode = !arena[index].orNode;
+    for(; moves; moves &= moves - 1) {
+        Node child{moves & (~moves + 1), index, 0, 1, 1, 0, orNode};
+        Position P2(P);
+        P2.play(child.move);
+        uint64_t child_moves;
+        evaluate(child, P2, child_moves);
+        arena.push_back(child);
+    }
+
+    arena[index].firstChild = first;
+    arena[index].nbChildren = arena.size() - first;
+}
+
+void ProofNumberSearch::update(uint32_t index) {
+    for(;;) {
+        Node &node = arena[index];
+        uint32_t pn, dn;
+        if(node.orNode) { // proven by any child, disproven by all of them
+            pn = INF;
+            dn = 0;
+            for(uint32_t c = node.firstChild; c < node.firstChild + node.nbChildren; c++) {
+                pn = std::min(pn, arena[c].pn);
+                dn = std::min(INF, dn + arena[c].dn);
+            }
+        } else { // proven by all the children, disproven by any
+            pn = 0;
+            dn = INF;
+            for(uint32_t c = node.firstChild; c < node.firstChild + node.nbChildren; c++) {
+                pn = std::min(INF, pn + arena[c].pn);
+                dn = std::min(dn, arena[c].dn);
+            }
+        }
+
+        if(pn == node.pn && dn == node.dn && index != 0) return; // nothing changes above
+        node.pn = pn;
+        node.dn = dn;
+        if(index == 0) return;
+        index = node.parent;
+    }
+}
+
+int ProofNumberSearch::getWinningMove(const Position &P) {
+    arena.clear();
+    arena.push_back(Node{0, 0, 0, 1, 1, 0, true});
+    expand(0, P);
+    if(arena[0].firstChild) update(0);
+
+    while(arena[0].pn != 0 && arena[0].dn != 0 && !stopped) {
+        if(arena.size() + Position::WIDTH > max_nodes) return -1; // out of memory, give up
+
+        // walk down to the most proving node
+        uint32_t index = 0;
+        Position P2(P);
+        while(arena[index].firstChild) {
+            const Node &node = arena[index];
+            uint32_t best = node.firstChild;
+            for(uint32_t c = node.firstChild + 1; c < node.firstChild + node.nbChildren; c++)
+                if(node.orNode ? arena[c].pn < arena[best].pn : arena[c].dn < arena[best].dn)
+                    best = c;
+            index = best;
+            P2.play(arena[index].move);
+        }
+
+        expand(index, P2);
+        update(index);
+    }
+
+    if(stopped || arena[0].pn != 0) return -1;
+
+    for(uint32_t c = arena[0].firstChild; c < arena[0].firstChild + arena[0].nbChildren; c++)
+        if(arena[c].pn == 0)
+            return Position::moveColumn(arena[c].move);
+
+    // proven at the root itself: an immediate win
+    for(int col = 0; col < Position::WIDTH; col++)
+        if(P.canPlay(col) && P.isWinningMove(col))
+            return col;
+    return -1;
+}
+
+// Constructor
+ProofNumberSearch::ProofNumberSearch(unsigned int max_nodes) : max_nodes{max_nodes} {
+}
+
+} // namespace Connect4
+} // namespace GameSolver
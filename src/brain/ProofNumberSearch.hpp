@@ -0,0 +1,79 @@
+#ifndef PROOF_NUMBER_SEARCH_HPP
+#define PROOF_NUMBER_SEARCH_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "Position.hpp"
+
+namespace GameSolver {
+namespace Connect4 {
+
+/**
+ * Proof-number search (L. V. Allis) answering a single question:
+ * can the player to move force a win?
+ *
+ * Best first, the search always expands the most proving node, so decisive positions
+ * are usually proven with far fewer nodes than a depth first search would explore.
+ * It does not compute how fast the game is won, only whether it is.
+ *
+ * The tree lives in an arena of fixed size, the search gives up when the arena is full.
+ * The search can be stopped from another thread, it is meant to run next to the
+ * alpha-beta Solver and to be dropped as soon as the Solver has the answer.
+ */
+class ProofNumberSearch {
+public:
+
+    /**
+     * Look for a winning move.
+     * @param P: the position to search, nobody should already have won
+     * @return the 0-based column of a winning move,
+     *         -1 if the player to move cannot win or if the search gave up or was stopped.
+     */
+    int getWinningMove(const Position &P);
+
+    /**
+     * Stop the running search, can be called from any thread.
+     * Every following search is stopped immediately until clearStop is called.
+     */
+    void stop() {
+        stopped = true;
+    }
+
+    void clearStop() {
+        stopped = false;
+    }
+
+    explicit ProofNumberSearch(unsigned int max_nodes = 1 << 20);
+
+private:
+    static const uint32_t INF = UINT32_MAX / 2;
+
+    struct Node {
+        uint64_t move;        // move leading to this node
+        uint32_t parent;      // index of the parent in the arena
+        uint32_t firstChild;  // index of the first child in the arena, 0 if not expanded
+        uint32_t pn;          // proof number
+        uint32_t dn;          // disproof number
+        uint8_t nbChildren;   // number of children
+        bool orNode;          // true when the player to move is the root player
+    };
+
+    std::vector<Node> arena;
+    const unsigned int max_nodes;
+    std::atomic<bool> stopped{false};
+
+    /**
+     * Set the proof and disproof numbers of a new node from its position
+     * @param moves: set to the non losing moves of the player to move if the node is not solved
+     */
+    static void evaluate(Node &node, const Position &P, uint64_t &moves);
+
+    void expand(uint32_t index, const Position &P);
+    void update(uint32_t index);
+};
+
+} // namespace Connect4
+} // namespace GameSolver
+#endif
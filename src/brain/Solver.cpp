@@ -17,15 +17,63 @@
  */
 
 #include <cassert>
+#include <climits>
 #include "Solver.hpp"
 #include "MoveSorter.hpp"
 #include "MoveChooser.hpp"
+#include "ThreatOracle.hpp"
+#include "Evaluator.hpp"
 
 using namespace GameSolver::Connect4;
 
 namespace GameSolver {
 namespace Connect4 {
 
+template<int W, int H, int N>
+template<int EMPTY>
+int BasicSolver<W, H, N>::endgame(Empty<EMPTY>, position_t &P, bitboard_t possible, int alpha, int beta) const {
+    const int min = -(EMPTY - 2) / 2;   // lower bound of score as opponent cannot win next move
+    if(alpha < min) {
+        alpha = min;
+        if(alpha >= beta) return alpha;
+    }
+
+    const int max = (EMPTY - 1) / 2;    // upper bound of our score as we cannot win immediately
+    if(beta > max) {
+        beta = max;
+        if(alpha >= beta) return beta;
+    }
+
+    for(int i = 0; i < position_t::WIDTH; i++) {
+        const bitboard_t move = possible & position_t::column_mask(columnOrder[i]);
+        if(!move) continue;
+
+        const typename position_t::Threats threats = P.threats();
+        P.play(move);
+        const bitboard_t next = P.possibleNonLosingMoves();
+        int score;
+        if(next == 0)             // opponent cannot avoid to lose
+            score = (EMPTY - 1) / 2;
+        else if(EMPTY - 1 <= 2)   // draw game
+            score = 0;
+        else
+            score = -endgame(Empty<EMPTY - 1>(), P, next, -beta, -alpha);
+        P.undo(move, threats);
+
+        if(score >= beta) return score;
+        if(score > alpha) alpha = score;
+    }
+
+    return alpha;
+}
+
+template<int W, int H, int N>
+template<int MAX_EMPTY>
+int BasicSolver<W, H, N>::endgame(Empty<MAX_EMPTY>, int empty, position_t &P, bitboard_t possible, int alpha, int beta) const {
+    return empty == MAX_EMPTY ? endgame(Empty<MAX_EMPTY>(), P, possible, alpha, beta)
+                              : endgame(Empty<MAX_EMPTY - 1>(), empty, P, possible, alpha, beta);
+}
+
 /**
  * Reccursively score connect 4 position using negamax variant of alpha-beta algorithm.
  * @param: position to evaluate, this function assumes nobody already won and
@@ -38,144 +86,550 @@ namespace Connect4 {
  * - if actual score of position >= beta then beta <= return value <= actual score
  * - if alpha <= actual score <= beta then return value = actual score
  */
-int Solver::negamax(const Position &P, int alpha, int beta, int depth) {
+template<int W, int H, int N>
+template<class Policy>
+int BasicSolver<W, H, N>::negamax(position_t &P, int alpha, int beta, int depth) {
     assert(alpha < beta);
     assert(!P.canWinNext());
 
-    uint64_t possible = P.possibleNonLosingMoves();
+    if(stopped.load(std::memory_order_relaxed)) return 0; // unwind, nothing is stored on the way back
+
+    if(Policy::STATS) nodeCount++;
+
+    const int ply = P.nbMoves();
+    pvLength[ply] = ply; // no line known below this node yet
+    evaluatedSides[ply] = PROVEN;
+
+    bitboard_t possible = P.possibleNonLosingMoves();
     if(possible == 0)     // if no possible non losing move, opponent wins next move
-        return -(Position::WIDTH * Position::HEIGHT - P.nbMoves()) / 2;
+        return -(position_t::WIDTH * position_t::HEIGHT - P.nbMoves()) / 2;
 
-    if(P.nbMoves() >= Position::WIDTH * Position::HEIGHT - 2) // check for draw game
+    if(P.nbMoves() >= position_t::WIDTH * position_t::HEIGHT - 2) // check for draw game
         return 0;
 
-    int min = -(Position::WIDTH * Position::HEIGHT - 2 - P.nbMoves()) / 2;	// lower bound of score as opponent cannot win next move
+    const int empty = position_t::WIDTH * position_t::HEIGHT - P.nbMoves();
+    if(empty <= ENDGAME_EMPTY && (!Policy::DEPTH_LIMITED || depth >= empty)) // the end of the game is reached without depth limit
+        return endgame(Empty<ENDGAME_EMPTY>(), empty, P, possible, alpha, beta);
+
+    int min = -(position_t::WIDTH * position_t::HEIGHT - 2 - P.nbMoves()) / 2;	// lower bound of score as opponent cannot win next move
     if(alpha < min) {
         alpha = min;                     // there is no need to keep alpha below our max possible score.
         if(alpha >= beta) return alpha;  // prune the exploration if the [alpha;beta] window is empty.
     }
 
-    int max = (Position::WIDTH * Position::HEIGHT - 1 - P.nbMoves()) / 2;	// upper bound of our score as we cannot win immediately
+    int max = (position_t::WIDTH * position_t::HEIGHT - 1 - P.nbMoves()) / 2;	// upper bound of our score as we cannot win immediately
     if(beta > max) {
         beta = max;                     // there is no need to keep beta above our max possible score.
         if(alpha >= beta) return beta;  // prune the exploration if the [alpha;beta] window is empty.
     }
 
-    const uint64_t key = P.key();
-    if(int val = transTable.get(key)) {
-        if(val > Position::MAX_SCORE - Position::MIN_SCORE + 1) { // we have an lower bound
-            min = val + 2 * Position::MIN_SCORE - Position::MAX_SCORE - 2;
+    max = BasicThreatOracle<position_t>::upperBound(P);	// upper bound proven by the claimeven rule, if any
+    if(beta > max) {
+        beta = max;
+        if(alpha >= beta) return beta;
+    }
+
+    const bitboard_t key = P.key();
+    // a depth reaching the end of the game gives exact bounds, shared with the unlimited search
+    // the bound of a depth limited search may rest on evaluations, unless it is beyond any evaluation
+    const bool tagged = Policy::DEPTH_LIMITED && depth < empty;
+    const table_key_t entry = tagged ? table_key_t(key) | table_key_t(depth + 1) << KEY_SIZE : table_key_t(key);
+    if(int val = transTable.get(entry)) {
+        if(val > position_t::MAX_SCORE - position_t::MIN_SCORE + 1) { // we have an lower bound
+            min = val + 2 * position_t::MIN_SCORE - position_t::MAX_SCORE - 2;
             if(alpha < min) {
                 alpha = min;                     // there is no need to keep beta above our max possible score.
+                if(tagged && min <= BasicEvaluator<position_t>::MAX_EVALUATION) evaluatedSides[ply] |= LOWER_EVALUATED;
                 if(alpha >= beta) return alpha;  // prune the exploration if the [alpha;beta] window is empty.
             }
         } else { // we have an upper bound
-            max = val + Position::MIN_SCORE - 1;
+            max = val + position_t::MIN_SCORE - 1;
             if(beta > max) {
                 beta = max;                     // there is no need to keep beta above our max possible score.
+                if(tagged && max >= -BasicEvaluator<position_t>::MAX_EVALUATION) evaluatedSides[ply] |= UPPER_EVALUATED;
                 if(alpha >= beta) return beta;  // prune the exploration if the [alpha;beta] window is empty.
             }
         }
     }
 
-    if(int val = book.get(P)) return val + Position::MIN_SCORE - 1; // look for solutions stored in opening book
+    if(Policy::BOOK)
+        if(int val = book.get(P)) return val + position_t::MIN_SCORE - 1; // look for solutions stored in opening book
 
-    if (depth == 0) {
-        return 0; // TODO: I'm not sure about this
-    } else {
-        depth > 0 ? --depth : depth; // if depth < 0 go to infinite depth
+    if(Policy::DEPTH_LIMITED && (!extensions || (possible & (possible - 1)))) { // a forced move does not consume depth
+        if (depth == 0) { // horizon
+            evaluatedSides[ply] = LOWER_EVALUATED | UPPER_EVALUATED;
+            if(!evaluation) return 0;
+            int value = BasicEvaluator<position_t>::evaluate(P);
+            const int cap = (empty - 1) / 2; // a win or loss proven before the horizon scores above the evaluation
+            if(value > cap) value = cap;
+            if(value < -cap) value = -cap;
+            if(value > max) value = max; // within the proven bounds of the position
+            if(value < min) value = min;
+            return value;
+        }
+        --depth;
     }
 
-    MoveSorter moves;
-    for(int i = Position::WIDTH; i--;)
-        if(uint64_t move = possible & Position::column_mask(columnOrder[i]))
-            moves.add(move, P.moveScore(move));
+    const int hint = hintKey[ply] == key ? hintColumn[ply] : -1; // column of the line expected by the previous search
+    BasicMoveSorter<position_t> moves;
+    for(int i = position_t::WIDTH; i--;)
+        if(bitboard_t move = possible & position_t::column_mask(columnOrder[i]))
+            moves.add(move, columnOrder[i] == hint ? HINT_SCORE : BasicMoveSorter<position_t>::score(P, move, columnOrder[i]));
 
-    while(uint64_t next = moves.getNext()) {
-        Position P2(P);
-        P2.play(next);  // It's opponent turn in P2 position after current player plays x column.
-        int score = -negamax(P2, -beta, -alpha, depth); // explore opponent's score within [-beta;-alpha] windows:
-        // no need to have good precision for score better than beta (opponent's score worse than -beta)
-        // no need to check for score worse than alpha (opponent's score worse better than -alpha)
+    int best = INT_MIN;
+    int searched = 0; // number of moves already searched at this node
+    int lower = evaluatedSides[ply] & LOWER_EVALUATED; // side of alpha, until a move raises it
+    int upper = PROVEN; // the upper bound is the best bound of the moves
+    while(bitboard_t next = moves.getNext()) {
+        const typename position_t::Threats threats = P.threats();
+        P.play(next);  // It's opponent turn in P after current player plays x column, until the move is taken back.
+        int score;
+        if(Policy::DEPTH_LIMITED && reductions && searched >= LMR_MOVES && depth >= LMR_DEPTH) {
+            // late move reduction: a move sorted late is first searched less deep, within a null window
+            score = -negamax<Policy>(P, -alpha - 1, -alpha, depth - 1);
+            if(score > alpha && !stopped.load(std::memory_order_relaxed)) // fail high, the move is searched again at full depth
+                score = -negamax<Policy>(P, -beta, -alpha, depth);
+        } else {
+            score = -negamax<Policy>(P, -beta, -alpha, depth); // explore opponent's score within [-beta;-alpha] windows:
+            // no need to have good precision for score better than beta (opponent's score worse than -beta)
+            // no need to check for score worse than alpha (opponent's score worse better than -alpha)
+        }
+        P.undo(next, threats);
+        searched++;
+        if(stopped.load(std::memory_order_relaxed)) return 0;
+        const int sides = negated(evaluatedSides[ply + 1]);
+
+        if(score > best) {
+            best = score;
+            if(score > alpha && score < beta) // the line of an exact score, a bound says nothing of the line
+                updatePV(ply, position_t::moveColumn(next));
+        }
 
         if(score >= beta) {
-            transTable.put(key, score + Position::MAX_SCORE - 2 * Position::MIN_SCORE + 2); // save the lower bound of the position
+            transTable.put(entry, score + position_t::MAX_SCORE - 2 * position_t::MIN_SCORE + 2); // save the lower bound of the position
+            evaluatedSides[ply] = (evaluatedSides[ply] & UPPER_EVALUATED) | (sides & LOWER_EVALUATED);
             return score;  // prune the exploration if we find a possible move better than what we were looking for.
         }
-        if(score > alpha) alpha = score; // reduce the [alpha;beta] window for next exploration, as we only
-        // need to search for a position that is better than the best so far.
+        upper |= sides & UPPER_EVALUATED;
+        if(score > alpha) { // reduce the [alpha;beta] window for next exploration, as we only
+            alpha = score;  // need to search for a position that is better than the best so far.
+            lower = sides & LOWER_EVALUATED;
+        }
     }
 
-    transTable.put(key, alpha - Position::MIN_SCORE + 1); // save the upper bound of the position
+    transTable.put(entry, alpha - position_t::MIN_SCORE + 1); // save the upper bound of the position
+    evaluatedSides[ply] = lower | upper;
     return alpha;
 }
 
-int Solver::solve(const Position &P, int depth, bool weak) {
-    if(P.canWinNext()) // check if win in one move as the Negamax function does not support this case.
-        return (Position::WIDTH * Position::HEIGHT + 1 - P.nbMoves()) / 2;
-    int min = -(Position::WIDTH * Position::HEIGHT - P.nbMoves()) / 2;
-    int max = (Position::WIDTH * Position::HEIGHT + 1 - P.nbMoves()) / 2;
+template<int W, int H, int N>
+int BasicSolver<W, H, N>::negamax(position_t &P, int alpha, int beta, int depth) {
+    const bool use_book = book.getDepth() >= P.nbMoves(); // deeper positions are never in the book
+
+    if(depth >= 0) {
+        if(use_book)
+            return stats ? negamax<SearchPolicy<true, true, true>>(P, alpha, beta, depth)
+                         : negamax<SearchPolicy<true, true, false>>(P, alpha, beta, depth);
+        else
+            return stats ? negamax<SearchPolicy<true, false, true>>(P, alpha, beta, depth)
+                         : negamax<SearchPolicy<true, false, false>>(P, alpha, beta, depth);
+    } else {
+        if(use_book)
+            return stats ? negamax<SearchPolicy<false, true, true>>(P, alpha, beta, depth)
+                         : negamax<SearchPolicy<false, true, false>>(P, alpha, beta, depth);
+        else
+            return stats ? negamax<SearchPolicy<false, false, true>>(P, alpha, beta, depth)
+                         : negamax<SearchPolicy<false, false, false>>(P, alpha, beta, depth);
+    }
+}
+
+template<int W, int H, int N>
+void BasicSolver<W, H, N>::updatePV(int ply, int column) {
+    pvTable[ply][ply] = column;
+    for(int i = ply + 1; i < pvLength[ply + 1]; i++)
+        pvTable[ply][i] = pvTable[ply + 1][i];
+    pvLength[ply] = pvLength[ply + 1] > ply + 1 ? pvLength[ply + 1] : ply + 1;
+}
+
+template<int W, int H, int N>
+std::vector<int> BasicSolver<W, H, N>::getPV(const position_t &P) const {
+    const int ply = P.nbMoves();
+    return std::vector<int>(pvTable[ply] + ply, pvTable[ply] + pvLength[ply]);
+}
+
+template<int W, int H, int N>
+void BasicSolver<W, H, N>::clearHints() {
+    for(int ply = 0; ply < position_t::WIDTH * position_t::HEIGHT; ply++) {
+        hintKey[ply] = 0;
+        hintColumn[ply] = -1;
+    }
+}
+
+template<int W, int H, int N>
+void BasicSolver<W, H, N>::setHints(const position_t &P, const std::vector<int> &pv) {
+    clearHints();
+
+    position_t P2(P);
+    for(int column : pv) {
+        if(!P2.canPlay(column) || P2.isWinningMove(column)) break;
+        hintKey[P2.nbMoves()] = P2.key();
+        hintColumn[P2.nbMoves()] = column;
+        P2.playCol(column);
+    }
+}
+
+template<int W, int H, int N>
+int BasicSolver<W, H, N>::solve(const position_t &P, int depth, bool weak) {
+    position_t P2(P); // the single position of the search
+    return search(P2, depth, weak);
+}
+
+template<int W, int H, int N>
+int BasicSolver<W, H, N>::search(position_t &P, int depth, bool weak) {
+    pvLength[P.nbMoves()] = P.nbMoves();
+    evaluatedSides[P.nbMoves()] = PROVEN;
+    if(P.canWinNext()) { // check if win in one move as the Negamax function does not support this case.
+        for(int col = 0; col < position_t::WIDTH; col++)
+            if(P.canPlay(col) && P.isWinningMove(col)) {
+                pvTable[P.nbMoves()][P.nbMoves()] = col;
+                pvLength[P.nbMoves()] = P.nbMoves() + 1;
+                break;
+            }
+        return (position_t::WIDTH * position_t::HEIGHT + 1 - P.nbMoves()) / 2;
+    }
+    int min = -(position_t::WIDTH * position_t::HEIGHT - P.nbMoves()) / 2;
+    int max = (position_t::WIDTH * position_t::HEIGHT + 1 - P.nbMoves()) / 2;
     if(weak) {
         min = -1;
         max = 1;
     }
+    if(max > BasicThreatOracle<position_t>::upperBound(P)) // short-circuit what can be proven without search
+        max = BasicThreatOracle<position_t>::upperBound(P);
 
     while(min < max) {                    // iteratively narrow the min-max exploration window
         int med = min + (max - min) / 2;
         if(med <= 0 && min / 2 < med) med = min / 2;
         else if(med >= 0 && max / 2 > med) med = max / 2;
         int r = negamax(P, med, med + 1, depth);   // use a null depth window to know if the actual score is greater or smaller than med
+        if(stopped) break;
         if(r <= med) max = r;
         else min = r;
     }
+
+    // the null windows only bound the scores: the line and the evaluated sides come from a search of the exact score
+    bool known = false;
+    if(!weak && !stopped) {
+        known = negamax(P, min - 1, min + 1, depth) == min;
+        if(!known) pvLength[P.nbMoves()] = P.nbMoves();
+    }
+    if(!known) // only an unlimited search is sure to be proven
+        evaluatedSides[P.nbMoves()] = depth >= 0 ? LOWER_EVALUATED | UPPER_EVALUATED : PROVEN;
     return min;
 }
 
-static int getMoveColumn(uint64_t move) {
-    for(int i = Position::WIDTH; i--;) {
-        if(move & Position::column_mask(i)) {
-            return i;
+template<int W, int H, int N>
+std::vector<int> BasicSolver<W, H, N>::completeLine(const position_t &P, std::vector<int> line, int score, int depth) {
+    position_t P2(P);
+    for(size_t i = 0; !stopped; i++) {
+        if(P2.nbMoves() == position_t::WIDTH * position_t::HEIGHT) break; // draw game
+        if(P2.canWinNext()) {
+            if(i == line.size())
+                for(int col = 0; col < position_t::WIDTH; col++)
+                    if(P2.canPlay(col) && P2.isWinningMove(col)) {
+                        line.push_back(col);
+                        break;
+                    }
+            break;
+        }
+
+        const bitboard_t non_losing = P2.possibleNonLosingMoves();
+        int next_depth = depth;
+        if(depth >= 0 && (!extensions || (non_losing & (non_losing - 1)))) { // same depth rule as negamax
+            if(depth == 0) { // horizon
+                if(line.size() > i) line.resize(i);
+                break;
+            }
+            next_depth = depth - 1;
         }
+
+        if(i == line.size()) {
+            int column = -1;
+            if(non_losing == 0) { // every move loses
+                for(int col = 0; col < position_t::WIDTH && column < 0; col++)
+                    if(P2.canPlay(col)) column = col;
+            } else {
+                for(int k = 0; k < position_t::WIDTH && column < 0 && !stopped; k++) {
+                    const bitboard_t move = non_losing & position_t::column_mask(columnOrder[k]);
+                    if(!move) continue;
+                    position_t P3(P2);
+                    P3.play(move);
+                    if(negamax(P3, -score - 1, -score + 1, next_depth) == -score) column = columnOrder[k];
+                }
+            }
+            if(column < 0 || stopped) break; // no move matches the score: the line is left as is
+            line.push_back(column);
+        }
+
+        P2.playCol(line[i]);
+        score = -score;
+        depth = next_depth;
     }
-    assert(false && "Unable to find a column for the move"); // I should never be here
+    return line;
 }
 
-int Solver::getBestMove(const Position &P, int depth, bool weak) {
-    uint64_t possible = P.possible();
-    if(possible == 0) {
-        return -1;
+template<int W, int H, int N>
+typename BasicSolver<W, H, N>::Analysis BasicSolver<W, H, N>::analyze(const position_t &P, int depth, bool weak, const Progress &progress) {
+    return analyze(P, depth, weak, progress, false);
+}
+
+template<int W, int H, int N>
+typename BasicSolver<W, H, N>::Analysis BasicSolver<W, H, N>::analyze(const position_t &P, int depth, bool weak, const Progress &progress, bool best_only) {
+    if(lastValid && lastKey == P.key() && lastDepth == depth && lastWeak == weak) {
+        if(progress)
+            for(int col = 0; col < position_t::WIDTH; col++)
+                if(last.scores[col] != Analysis::INVALID) progress(col, last.scores[col]);
+        return last;
+    }
+
+    Analysis analysis;
+    for(int col = 0; col < position_t::WIDTH; col++) {
+        analysis.scores[col] = Analysis::INVALID;
+        analysis.evaluated[col] = PROVEN;
     }
+    analysis.exact = depth < 0 && !weak;
 
     std::cerr << "-------\n";
 
-    MoveSorter moves;
-    for(int i = Position::WIDTH; i--;)
-        if(uint64_t move = possible & Position::column_mask(columnOrder[i]))
-            moves.add(move, P.moveScore(move));
+    const int win = (position_t::WIDTH * position_t::HEIGHT + 1 - P.nbMoves()) / 2; // score of an immediate win
+    const int loss = -(position_t::WIDTH * position_t::HEIGHT - P.nbMoves()) / 2;   // score of a move letting the opponent win
+    const bitboard_t non_losing = P.canWinNext() ? 0 : P.possibleNonLosingMoves();
 
-    MoveChooser chooser;
-    while(uint64_t next = moves.getNext()) {
-        Position P2(P);
-        P2.play(next);
-        int score = -solve(P2, depth, weak);
-        std::cerr << "next: " << getMoveColumn(next) << "  score: " << score << "\n";
-        chooser.add(next, score);
+    // the best score a move can reach without winning immediately, the search can stop there
+    int max = win - 1;
+    if(max > BasicThreatOracle<position_t>::upperBound(P))
+        max = BasicThreatOracle<position_t>::upperBound(P);
+
+    bitboard_t possible = P.possible();
+    const int hint = hintKey[P.nbMoves()] == P.key() ? hintColumn[P.nbMoves()] : -1;
+    BasicMoveSorter<position_t> moves;
+    for(int i = position_t::WIDTH; i--;)
+        if(bitboard_t move = possible & position_t::column_mask(columnOrder[i]))
+            moves.add(move, columnOrder[i] == hint ? HINT_SCORE : BasicMoveSorter<position_t>::score(P, move, columnOrder[i]));
+
+    const bool symmetric = P.isSymmetric();
+
+    position_t P2(P); // the moves are played and taken back on a single position
+    bool complete = true;
+    while(bitboard_t next = moves.getNext()) {
+        const int column = position_t::moveColumn(next);
+        const int mirror = position_t::WIDTH - 1 - column;
+        int score;
+        if(symmetric && analysis.scores[mirror] != Analysis::INVALID) { // same as the mirror move, already solved
+            score = analysis.scores[mirror];
+            analysis.evaluated[column] = analysis.evaluated[mirror];
+            analysis.pv[column].clear();
+            for(int col : analysis.pv[mirror])
+                analysis.pv[column].push_back(position_t::WIDTH - 1 - col);
+        } else if(P.isWinningMove(column)) {
+            score = win;
+            analysis.pv[column] = {column};
+        } else if(!P.canWinNext() && !(next & non_losing)) {
+            score = loss;
+            analysis.pv[column] = {column};
+        } else {
+            const typename position_t::Threats threats = P2.threats();
+            P2.play(next);
+            score = -search(P2, depth, weak);
+            analysis.evaluated[column] = negated(evaluatedSides[P2.nbMoves()]);
+            analysis.pv[column] = getPV(P2);
+            analysis.pv[column].insert(analysis.pv[column].begin(), column);
+            P2.undo(next, threats);
+        }
+        std::cerr << "next: " << column << "  score: " << score << "\n";
+        analysis.scores[column] = score;
+        if(progress && !stopped) progress(column, score);
+
+        if(symmetric && best_only && score >= max && mirror != column) { // the mirror move is as good, keep the random choice
+            analysis.scores[mirror] = score;
+            analysis.evaluated[mirror] = analysis.evaluated[column];
+            analysis.pv[mirror].clear();
+            for(int col : analysis.pv[column])
+                analysis.pv[mirror].push_back(position_t::WIDTH - 1 - col);
+        }
+
+        if(best_only && score >= max && moves.getNext()) { // no other move can be better
+            complete = false;
+            break;
+        }
     }
 
     std::cerr << "-------\n";
 
-    int best =  getMoveColumn(chooser.getBestMove());
+    if(!stopped && complete) { // the scores of a stopped search are meaningless
+        last = analysis;
+        lastKey = P.key();
+        lastDepth = depth;
+        lastWeak = weak;
+        lastValid = true;
+    }
+    return analysis;
+}
+
+template<int W, int H, int N>
+typename BasicSolver<W, H, N>::Line BasicSolver<W, H, N>::getBestLine(const position_t &P, int depth, bool weak) {
+    bitboard_t possible = P.possible();
+    if(possible == 0) {
+        return Line{-1, 0, {}, false};
+    }
+
+    BasicMoveChooser<position_t> chooser;
+
+    // tactical pre-pass, no search needed
+    if(P.canWinNext()) {
+        for(int col = 0; col < position_t::WIDTH; col++)
+            if(P.canPlay(col) && P.isWinningMove(col))
+                chooser.add(possible & position_t::column_mask(col), 0);
+        const int best = position_t::moveColumn(chooser.getBestMove());
+        return Line{best, (position_t::WIDTH * position_t::HEIGHT + 1 - P.nbMoves()) / 2, {best}, false};
+    }
+
+    const bitboard_t non_losing = P.possibleNonLosingMoves();
+    if(non_losing == 0) { // every move lets the opponent win
+        for(int col = 0; col < position_t::WIDTH; col++)
+            if(P.canPlay(col))
+                chooser.add(possible & position_t::column_mask(col), 0);
+        const int best = position_t::moveColumn(chooser.getBestMove());
+        const int score = -(position_t::WIDTH * position_t::HEIGHT - P.nbMoves()) / 2;
+        position_t P2(P);
+        P2.playCol(best);
+        std::vector<int> line = completeLine(P2, {}, -score, depth); // the winning move of the opponent
+        line.insert(line.begin(), best);
+        return Line{best, score, line, false};
+    }
+
+    if(!(non_losing & (non_losing - 1))) // a single move does not lose immediately: forced
+        return Line{position_t::moveColumn(non_losing), Line::UNKNOWN, {}, false};
+
+    Analysis analysis = analyze(P, depth, weak, nullptr, true);
+
+    if(stopped) return Line{-1, 0, {}, false};
+    if(stats) std::cerr << "nodes: " << nodeCount << "\n";
+
+    for(int col = 0; col < position_t::WIDTH; col++)
+        if(analysis.scores[col] != Analysis::INVALID)
+            chooser.add(possible & position_t::column_mask(col), analysis.scores[col]);
+
+    int best =  position_t::moveColumn(chooser.getBestMove());
     std::cerr << "best: " << best << "  score: " << chooser.getBestScore() << "\n";
     std::cerr << "-------\n";
 
-    return best;
+    std::vector<int> line = analysis.pv[best];
+    if(!weak && !P.isWinningMove(best)) { // the searched line stops at the first position known without search
+        position_t P2(P);
+        P2.playCol(best);
+        line = completeLine(P2, std::vector<int>(line.begin() + 1, line.end()), -chooser.getBestScore(), depth);
+        line.insert(line.begin(), best);
+    }
+
+    // a win rests on the best move only, a loss on every move, a draw on both
+    const int score = chooser.getBestScore();
+    int sides = analysis.evaluated[best] & LOWER_EVALUATED;
+    for(int col = 0; col < position_t::WIDTH; col++)
+        if(analysis.scores[col] != Analysis::INVALID) sides |= analysis.evaluated[col] & UPPER_EVALUATED;
+    const bool evaluated = score > 0 ? sides & LOWER_EVALUATED : score < 0 ? sides & UPPER_EVALUATED : sides != PROVEN;
+
+    setHints(P, line); // the next search starts two plies down this line
+    return Line{best, score, line, evaluated};
+}
+
+template<int W, int H, int N>
+int BasicSolver<W, H, N>::getBestMove(const position_t &P, int depth, bool weak) {
+    return getBestLine(P, depth, weak).column;
 }
 
 // Constructor
-Solver::Solver() {
-    for(int i = 0; i < Position::WIDTH; i++) // initialize the column exploration order, starting with center columns
-        columnOrder[i] = Position::WIDTH / 2 + (1 - 2 * (i % 2)) * (i + 1) / 2; // example for WIDTH=7: columnOrder = {3, 4, 2, 5, 1, 6, 0}
+template<int W, int H, int N>
+BasicSolver<W, H, N>::BasicSolver() {
+    clearHints();
+    for(int i = 0; i < position_t::WIDTH; i++) // initialize the column exploration order, starting with center columns
+        columnOrder[i] = position_t::WIDTH / 2 + (1 - 2 * (i % 2)) * (i + 1) / 2; // example for WIDTH=7: columnOrder = {3, 4, 2, 5, 1, 6, 0}
 }
 
+/**
+ * BoardSolver of a board size and alignment length, positions are replayed from their sequence of moves.
+ */
+template<int W, int H, int N>
+class SizedSolver : public BoardSolver {
+public:
+    int solve(const std::string &seq, int depth, bool weak) override {
+        BasicPosition<W, H, N> P;
+        if(P.playSeq(seq) != seq.size()) return INVALID;
+        return solver.solve(P, depth, weak);
+    }
+
+    int getBestMove(const std::string &seq, int depth, bool weak) override {
+        BasicPosition<W, H, N> P;
+        if(P.playSeq(seq) != seq.size()) return -1;
+        return solver.getBestMove(P, depth, weak);
+    }
+
+    void reset() override {
+        solver.reset();
+    }
+
+    void loadBook(std::string book_file) override {
+        solver.loadBook(book_file);
+    }
+
+    void clearBook() override {
+        solver.clearBook();
+    }
+
+    void stop() override {
+        solver.stop();
+    }
+
+    void clearStop() override {
+        solver.clearStop();
+    }
+
+    int width() const override {
+        return W;
+    }
+
+    int height() const override {
+        return H;
+    }
+
+    int length() const override {
+        return N;
+    }
+
+private:
+    BasicSolver<W, H, N> solver;
+};
+
+BoardSolver *BoardSolver::create(int width, int height, int length) {
+    if(width == 7 && height == 6 && length == 4) return new SizedSolver<7, 6, 4>();
+    if(width == 7 && height == 6 && length == 3) return new SizedSolver<7, 6, 3>();
+    if(width == 7 && height == 6 && length == 5) return new SizedSolver<7, 6, 5>();
+#ifdef __SIZEOF_INT128__
+    if(width == 8 && height == 7 && length == 4) return new SizedSolver<8, 7, 4>();
+    if(width == 9 && height == 7 && length == 4) return new SizedSolver<9, 7, 4>();
+    if(width == 9 && height == 7 && length == 5) return new SizedSolver<9, 7, 5>();
+#endif
+    return nullptr;
+}
+
+// The compiled board sizes and alignment lengths, larger boards use 128 bits bitboards
+template class BasicSolver<7, 6, 4>;
+template class BasicSolver<7, 6, 3>;
+template class BasicSolver<7, 6, 5>;
+#ifdef __SIZEOF_INT128__
+template class BasicSolver<8, 7, 4>;
+template class BasicSolver<9, 7, 4>;
+template class BasicSolver<9, 7, 5>;
+#endif
+
 } // namespace Connect4
 } // namespace GameSolver
@@ -19,44 +19,283 @@
 #ifndef SOLVER_HPP
 #define SOLVER_HPP
 
+#include <atomic>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
 #include "Position.hpp"
+#include "MoveStatistics.hpp"
 #include "TranspositionTable.hpp"
 #include "OpeningBook.hpp"
 
 namespace GameSolver {
 namespace Connect4 {
 
-class Solver {
+/**
+ * Solver for a board of W columns and H rows, where N disks have to be aligned to win.
+ * Only the instantiations listed at the end of Solver.cpp are available.
+ */
+template<int W, int H, int N = 4>
+class BasicSolver {
 public:
+    typedef BasicPosition<W, H, N> position_t;
+    typedef typename position_t::bitboard_t bitboard_t;
+
+    /**
+     * Sides of a score resting on the evaluation of positions at the horizon of a depth limited search,
+     * the other sides are proven.
+     */
+    enum Evaluated {
+        PROVEN = 0,
+        LOWER_EVALUATED = 1, // the actual score may be lower
+        UPPER_EVALUATED = 2  // the actual score may be higher
+    };
+
+    /**
+     * Scores of all the columns of a position, for the player to move.
+     */
+    struct Analysis {
+        static const int INVALID = -1000; // score of a column that cannot be played
+
+        int scores[position_t::WIDTH];
+        std::vector<int> pv[position_t::WIDTH]; // line expected after each column, starting with the column
+        int evaluated[position_t::WIDTH]; // Evaluated sides of the score of each column
+        bool exact; // false when the scores are only bounded, by the depth limit or a weak search
 
-    int solve(const Position &P, int depth = -1, bool weak = false);
+        /**
+         * @return the score of the position, the best score of its columns, INVALID if no column can be played
+         */
+        int score() const {
+            int best = INVALID;
+            for(int col = 0; col < position_t::WIDTH; col++)
+                if(scores[col] > best) best = scores[col];
+            return best;
+        }
+    };
 
-    int getBestMove(const Position &P, int depth = -1, bool weak = false);
+    int solve(const position_t &P, int depth = -1, bool weak = false);
+
+    /**
+     * Called by analyze each time the score of a column is known, with the column and its score.
+     */
+    typedef std::function<void(int, int)> Progress;
+
+    /**
+     * Solve every possible move of a position, sharing the transposition table.
+     * The analysis of the last position is kept: asking again for the same position,
+     * depth and weakness, or asking for its best move, does not search again.
+     * @param progress: if set, called for each column as soon as it is solved
+     */
+    Analysis analyze(const position_t &P, int depth = -1, bool weak = false, const Progress &progress = nullptr);
+
+    /**
+     * A move with its score and the line expected to follow (principal variation).
+     */
+    struct Line {
+        static const int UNKNOWN = -1000; // score of a move played without search
+
+        int column;          // -1 if no move is allowed
+        int score;           // UNKNOWN if the move was not searched
+        std::vector<int> pv; // columns played from the position, starting with column, empty if not searched
+        bool evaluated;      // the outcome of the score, win, draw or loss, rests on an evaluation at the horizon
+    };
+
+    /**
+     * @return one of the best columns of the position, chosen at random, and its line.
+     * The line is followed first by the next search, two plies later.
+     * Immediate wins and losses are played without search, so is a single non losing move (forced move):
+     * its score is then Line::UNKNOWN and its line empty.
+     * The search stops as soon as a move reaches the best score possible in the position.
+     */
+    Line getBestLine(const position_t &P, int depth = -1, bool weak = false);
+
+    /**
+     * @return one of the best columns of the analysis of the position, chosen at random, -1 if no move is allowed.
+     */
+    int getBestMove(const position_t &P, int depth = -1, bool weak = false);
 
     void reset() {
         transTable.reset();
+        lastValid = false;
+        clearHints();
     }
 
     void loadBook(std::string book_file) {
         book.load(book_file);
+        lastValid = false;
     }
 
     void clearBook() {
         book.clear();
+        lastValid = false;
+    }
+
+    /**
+     * @return true if every move of the position is scored by the opening book: its search is immediate.
+     */
+    bool inBook(const position_t &P) const {
+        return book.getDepth() > P.nbMoves();
+    }
+
+    /**
+     * @return true if the position is on the line expected by the last search:
+     * the transposition table already holds most of its tree.
+     */
+    bool isExpected(const position_t &P) const {
+        return P.nbMoves() < position_t::WIDTH * position_t::HEIGHT && hintColumn[P.nbMoves()] >= 0 && hintKey[P.nbMoves()] == P.key();
+    }
+
+    /**
+     * Stop the running search as soon as possible, can be called from any thread.
+     * The result of a stopped search is meaningless, getBestMove returns -1.
+     * Every following search is stopped immediately until clearStop is called.
+     */
+    void stop() {
+        stopped = true;
+    }
+
+    void clearStop() {
+        stopped = false;
+    }
+
+    /**
+     * Extend depth limited searches along forced lines (enabled by default):
+     * a position with a single non losing move does not consume depth.
+     * Threats are extended as well, since the answer to a threat is a forced move.
+     */
+    void setExtensions(bool enable) {
+        extensions = enable;
+        lastValid = false;
+    }
+
+    /**
+     * Reduce the depth of the late moves in depth limited searches (enabled by default),
+     * a reduced move failing high is searched again at full depth.
+     */
+    void setReductions(bool enable) {
+        reductions = enable;
+        lastValid = false;
+    }
+
+    /**
+     * Evaluate the positions at the horizon of depth limited searches (enabled by default), see Evaluator.
+     * When disabled, they score 0 as a draw.
+     */
+    void setEvaluation(bool enable) {
+        evaluation = enable;
+        lastValid = false;
+    }
+
+    /**
+     * Count the nodes explored by the following searches.
+     * Counting is compiled out of the search when disabled.
+     */
+    void enableStats(bool enable) {
+        stats = enable;
+        nodeCount = 0;
     }
 
-    Solver(); // Constructor
+    /**
+     * @return number of negamax nodes explored since stats were enabled.
+     */
+    unsigned long long getNodeCount() const {
+        return nodeCount;
+    }
+
+    BasicSolver(); // Constructor
 
 private:
     static const int TABLE_SIZE = 23; // store 2^TABLE_SIZE elements in the transpositiontbale
-    TranspositionTable < uint_t < Position::WIDTH*(Position::HEIGHT + 1) - TABLE_SIZE >, uint8_t, TABLE_SIZE > transTable;
-    OpeningBook book{Position::WIDTH, Position::HEIGHT}; // opening book
-    int columnOrder[Position::WIDTH]; // column exploration order
+    // Depth limited entries are stored under the position key tagged with the remaining depth (above the key bits),
+    // so that the bounds of shallow searches are never mixed with deeper or exact ones.
+    static const int KEY_SIZE = position_t::WIDTH * (position_t::HEIGHT + 1);
+    static const int DEPTH_BITS = log2(position_t::WIDTH * position_t::HEIGHT) + 1; // the tag is at most the number of cells
+    static_assert(KEY_SIZE + DEPTH_BITS <= 128, "Tagged keys do not fit in 128bits");
+    typedef typename bitboard_type<(KEY_SIZE + DEPTH_BITS > 64)>::type table_key_t;
+    TranspositionTable < uint_t < KEY_SIZE + DEPTH_BITS - TABLE_SIZE >, uint8_t, TABLE_SIZE, table_key_t > transTable;
+    OpeningBook book{position_t::WIDTH, position_t::HEIGHT}; // opening book
+    int columnOrder[position_t::WIDTH]; // column exploration order
+    std::atomic<bool> stopped{false};
+    bool stats = false;
+
+    // Triangular principal variation table: pvTable[ply][ply..pvLength[ply]) is the best line found
+    // by the last search of the node at ply. Only the moves of exact scores are kept, a bound says nothing of the line.
+    int pvTable[position_t::WIDTH * position_t::HEIGHT][position_t::WIDTH * position_t::HEIGHT];
+    int pvLength[position_t::WIDTH * position_t::HEIGHT + 1];
+
+    // Evaluated sides of the score returned by the last search of the node at each ply, read back by its parent
+    int evaluatedSides[position_t::WIDTH * position_t::HEIGHT + 1];
+
+    // Line of the last best move: the column to try first in the position of each ply, if it is reached again
+    bitboard_t hintKey[position_t::WIDTH * position_t::HEIGHT];
+    int hintColumn[position_t::WIDTH * position_t::HEIGHT];
+    static const int HINT_SCORE = (position_t::WIDTH * position_t::HEIGHT + 1) * MoveStatistics<W, H>::SCALE; // above any move score
+
+    /**
+     * Same as the public analyze, stopping as soon as a move reaches the best possible score if best_only is set.
+     * Such an incomplete analysis is not kept.
+     */
+    Analysis analyze(const position_t &P, int depth, bool weak, const Progress &progress, bool best_only);
+
+    /**
+     * Same as solve, on a position the search plays and takes back its moves on.
+     */
+    int search(position_t &P, int depth, bool weak);
+
+    void updatePV(int ply, int column);
+
+    /**
+     * @return the Evaluated sides of the score of a move, from the sides of the score of the position it leads to.
+     */
+    static int negated(int evaluated) {
+        return (evaluated & LOWER_EVALUATED ? UPPER_EVALUATED : PROVEN) | (evaluated & UPPER_EVALUATED ? LOWER_EVALUATED : PROVEN);
+    }
+
+    /**
+     * Complete a line up to the end of the game, or up to the horizon of a depth limited search,
+     * each added move being checked by an exact search of the position it leads to.
+     * @param P: position the line starts from
+     * @param line: the columns of the line known so far, played from P
+     * @param score: the score of P
+     * @param depth: the depth of the search of P, -1 if unlimited
+     * @return the completed line, or the line known so far if no move matches the score.
+     */
+    std::vector<int> completeLine(const position_t &P, std::vector<int> line, int score, int depth);
+    std::vector<int> getPV(const position_t &P) const; // line found by the last search of P
+    void setHints(const position_t &P, const std::vector<int> &pv);
+    void clearHints(); // no line expected at any ply
+
+    // last complete analysis and the request it answers
+    Analysis last;
+    bitboard_t lastKey;
+    int lastDepth;
+    bool lastWeak;
+    bool lastValid = false;
+    unsigned long long nodeCount = 0;
+    bool extensions = true;
+    bool reductions = true;
+    bool evaluation = true;
+    static const int LMR_MOVES = 3; // moves searched at full depth before reducing
+    static const int LMR_DEPTH = 4; // least remaining depth to reduce
+
+    /**
+     * Options of a search, fixed for the whole search so that
+     * negamax is compiled once for each combination, without the dead branches.
+     */
+    template<bool depth_limited, bool book, bool stats>
+    struct SearchPolicy {
+        static const bool DEPTH_LIMITED = depth_limited; // stop at a given depth instead of the end of the game
+        static const bool BOOK = book;                   // probe the opening book
+        static const bool STATS = stats;                 // count the explored nodes
+    };
 
     /**
      * Reccursively score connect 4 position using negamax variant of alpha-beta algorithm.
      * @param: position to evaluate, this function assumes nobody already won and
-     *         current player cannot win next move. This has to be checked before
+     *         current player cannot win next move. This has to be checked before.
+     *         The moves are played and taken back on the position, it is unchanged on return.
      * @param: alpha < beta, a score window within which we are evaluating the position.
      *         depth, the depth it should search for (-1 infinite)
      *
@@ -65,7 +304,78 @@ private:
      * - if actual score of position >= beta then beta <= return value <= actual score
      * - if alpha <= actual score <= beta then return value = actual score
      */
-    int negamax(const Position &P, int alpha, int beta, int depth);
+    template<class Policy>
+    int negamax(position_t &P, int alpha, int beta, int depth);
+
+    /**
+     * Select the negamax policy matching the search and run it, same parameters as negamax.
+     */
+    int negamax(position_t &P, int alpha, int beta, int depth);
+
+    static const int ENDGAME_EMPTY = 10; // positions with at most this number of empty cells are searched by endgame
+
+    // number of empty cells as a type, selects the unrolled endgame overload
+    template<int E> using Empty = std::integral_constant<int, E>;
+
+    /**
+     * Negamax specialized for positions with EMPTY empty cells, fully unrolled on EMPTY.
+     * The last plies hold a large part of the nodes of a full search and are cheap to explore,
+     * so no transposition table, opening book or move sorting is used there.
+     * @param: position to evaluate, same assumptions as negamax.
+     * @param: possible, the non losing moves of the position, not 0.
+     * @param: alpha < beta, a score window within which we are evaluating the position.
+     *
+     * @return same as negamax.
+     */
+    template<int EMPTY>
+    int endgame(Empty<EMPTY>, position_t &P, bitboard_t possible, int alpha, int beta) const;
+
+    int endgame(Empty<2>, position_t &, bitboard_t, int, int) const {
+        return 0; // draw game, never called
+    }
+
+    /**
+     * Call endgame for the given number of empty cells, being at most MAX_EMPTY.
+     */
+    template<int MAX_EMPTY>
+    int endgame(Empty<MAX_EMPTY>, int empty, position_t &P, bitboard_t possible, int alpha, int beta) const;
+
+    int endgame(Empty<3>, int, position_t &P, bitboard_t possible, int alpha, int beta) const {
+        return endgame(Empty<3>(), P, possible, alpha, beta);
+    }
+};
+
+/**
+ * The classic 7x6 solver
+ */
+typedef BasicSolver<7, 6, 4> Solver;
+
+/**
+ * Board size independent access to the solvers, for a size only known at runtime.
+ * Positions are given as sequences of 0-based columns, as in Position::playSeq.
+ */
+class BoardSolver {
+public:
+    static const int INVALID = -1000; // returned by solve for an invalid sequence of moves
+
+    /**
+     * Create the solver of a board size and alignment length.
+     * @return a new solver, nullptr if no solver is compiled for this game (see the end of Solver.cpp).
+     */
+    static BoardSolver *create(int width, int height, int length = 4);
+
+    virtual int solve(const std::string &seq, int depth = -1, bool weak = false) = 0;
+    virtual int getBestMove(const std::string &seq, int depth = -1, bool weak = false) = 0;
+    virtual void reset() = 0;
+    virtual void loadBook(std::string book_file) = 0;
+    virtual void clearBook() = 0;
+    virtual void stop() = 0;
+    virtual void clearStop() = 0;
+    virtual int width() const = 0;
+    virtual int height() const = 0;
+    virtual int length() const = 0;
+
+    virtual ~BoardSolver() {}
 };
 
 } // namespace Connect4
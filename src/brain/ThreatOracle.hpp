@@ -0,0 +1,62 @@
+#ifndef THREAT_ORACLE_HPP
+#define THREAT_ORACLE_HPP
+
+#include <cstdint>
+
+#include "Position.hpp"
+
+namespace GameSolver {
+namespace Connect4 {
+
+/**
+ * Rule based knowledge about a position, proven without search.
+ *
+ * The oracle implements the claimeven rule (V. Allis, "A Knowledge-based Approach of Connect-Four").
+ * When every column holds an even number of stones and it is player A's turn,
+ * player B can always answer in the column A just played (follow-up).
+ * Doing so, B gets every empty cell of the odd rows (0-based) and A every empty cell of the even rows:
+ * - if A cannot make an alignment with its stones and the empty even cells, A cannot win
+ * - if moreover B can make an alignment with its stones and the empty odd cells, B wins
+ *
+ * Both tests are a single alignment check on a bitboard, cheap enough to be done on every node.
+ * The rule needs columns of even height, nothing is proven on the other boards.
+ */
+template<class position_t>
+class BasicThreatOracle {
+public:
+    typedef typename position_t::bitboard_t bitboard_t;
+    /**
+     * Upper bound of the score of a position for the player to move.
+     * @param P: a position, nobody should already have won
+     * @return 0 if the player to move cannot win, -1 if it loses,
+     *         a value above any possible score if nothing can be proven.
+     */
+    static int upperBound(const position_t &P) {
+        if(position_t::HEIGHT % 2 != 0) // the top cell of a column is on an even row: a move there cannot be followed
+            return NO_BOUND;
+        if(P.possible() & odd_rows) // some column holds an odd number of stones
+            return NO_BOUND;
+
+        const bitboard_t empty = position_t::board_mask & ~P.mask;
+        const bitboard_t player = P.current_position;
+        const bitboard_t opponent = P.current_position ^ P.mask;
+
+        if(position_t::alignment(player | (empty & ~odd_rows)))
+            return NO_BOUND;
+        if(position_t::alignment(opponent | (empty & odd_rows)))
+            return -1; // latest possible loss
+        return 0;
+    }
+
+    static const int NO_BOUND = position_t::WIDTH * position_t::HEIGHT;
+
+private:
+    // cells of the odd rows (0-based) of the board
+    static const bitboard_t odd_rows = position_t::bottom_mask * (position_t::column_mask(0) & ~bitboard_t(0) / 3 * 2);
+};
+
+typedef BasicThreatOracle<Position> ThreatOracle;
+
+} // namespace Connect4
+} // namespace GameSolver
+#endif
@@ -0,0 +1,175 @@
+#include "Position.hpp"
+#include "OpeningBook.hpp"
+#include "MoveSorter.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace GameSolver::Connect4;
+
+/**
+ * Offline tool mining the opening books for move ordering statistics.
+ *
+ * In every position whose moves are all scored by a book, the best moves are the ones
+ * a search would like to try first: they are the cutoff moves of the position.
+ * For each pattern of a move (the number of winning cells it creates, see Position::moveScore)
+ * and each cell it lands on, the tool counts how often the move is playable and how often it is a best move,
+ * then prints the rates as the MoveStatistics.hpp header read by MoveSorter.
+ *
+ * Positions are sampled by random games played down to the depth of the book,
+ * and read from self-play logs: one game per line, as a sequence of 0-based columns (see Position::playSeq).
+ */
+static constexpr int PATTERNS = MoveStatistics<Position::WIDTH, Position::HEIGHT>::PATTERNS; // moves creating 0, 1, 2 or more winning cells
+
+struct MoveStatisticsCounts {
+  unsigned long long playable[PATTERNS][Position::WIDTH * Position::HEIGHT] = {};
+  unsigned long long best[PATTERNS][Position::WIDTH * Position::HEIGHT] = {};
+  unsigned long long positions = 0;
+};
+
+static int pattern(const Position &P, Position::bitboard_t move) {
+  const int score = P.moveScore(move);
+  return score < PATTERNS ? score : PATTERNS - 1;
+}
+
+/**
+ * Count the moves of a position if the book scores all of them.
+ */
+void count_position(const Position &P, const OpeningBook &book, MoveStatisticsCounts &counts) {
+  if(P.canWinNext()) return; // the immediate win is always searched first
+
+  int scores[Position::WIDTH];
+  int best = Position::MIN_SCORE - 1;
+  for(int col = 0; col < Position::WIDTH; col++) {
+    scores[col] = Position::MIN_SCORE - 1;
+    if(!P.canPlay(col)) continue;
+    Position P2(P);
+    P2.playCol(col);
+    const int val = book.get(P2);
+    if(!val) return; // not in the book: no statistics from this position
+    scores[col] = -(val + Position::MIN_SCORE - 1);
+    if(scores[col] > best) best = scores[col];
+  }
+
+  counts.positions++;
+  const Position::bitboard_t possible = P.possible();
+  for(int col = 0; col < Position::WIDTH; col++) {
+    if(!P.canPlay(col)) continue;
+    const Position::bitboard_t move = possible & Position::column_mask(col);
+    const int p = pattern(P, move);
+    const int c = MoveSorter::cell(move, col);
+    counts.playable[p][c]++;
+    if(scores[col] == best) counts.best[p][c]++;
+  }
+}
+
+/**
+ * Play random games down to the depth of the book, counting every position on the way.
+ * Positions are counted once, symmetric positions included.
+ */
+void sample_book(const OpeningBook &book, int games, MoveStatisticsCounts &counts) {
+  std::unordered_set<uint64_t> visited;
+  for(int game = 0; game < games; game++) {
+    Position P;
+    while(P.nbMoves() < book.getDepth() && !P.canWinNext()) {
+      const uint64_t key = P.key3();
+      if(!visited.count(key)) {
+        visited.insert(key);
+        count_position(P, book, counts);
+      }
+      const Position::bitboard_t moves = P.possibleNonLosingMoves();
+      if(!moves) break;
+      int col;
+      do col = std::rand() % Position::WIDTH; while(!(moves & Position::column_mask(col)));
+      P.playCol(col);
+    }
+  }
+}
+
+/**
+ * Count the positions of self-play games.
+ */
+void count_games(const std::vector<std::string> &games, const OpeningBook &book, MoveStatisticsCounts &counts) {
+  for(const std::string &line : games) {
+    Position P;
+    for(char c : line) {
+      const int col = c - '0';
+      if(col < 0 || col >= Position::WIDTH || !P.canPlay(col) || P.isWinningMove(col)) break;
+      if(P.nbMoves() < book.getDepth()) count_position(P, book, counts);
+      P.playCol(col);
+    }
+  }
+}
+
+/**
+ * Print the MoveStatistics.hpp header for the counts.
+ */
+void print_move_statistics(const MoveStatisticsCounts &counts, std::ostream &out) {
+  out << "#ifndef MOVE_STATISTICS_HPP\n"
+         "#define MOVE_STATISTICS_HPP\n\n"
+         "#include <cstdint>\n\n"
+         "namespace GameSolver {\n"
+         "namespace Connect4 {\n\n"
+         "/**\n"
+         " * Rates at which the moves are best moves, by pattern and cell, in 1/SCALE.\n"
+         " * The pattern of a move is the number of winning cells it creates, up to PATTERNS - 1.\n"
+         " * A cell is column * HEIGHT + row.\n"
+         " * No statistics are known for this board size: every rate is 0.\n"
+         " */\n"
+         "template<int W, int H>\n"
+         "struct MoveStatistics {\n"
+         "    static const int SCALE = 64;\n"
+         "    static const int PATTERNS = 3;\n\n"
+         "    static int rate(int, int) {\n"
+         "        return 0;\n"
+         "    }\n"
+         "};\n\n"
+         "/**\n"
+         " * Statistics of the classic board, generated by statistics.hpp\n"
+         " * from " << counts.positions << " positions scored by the opening books, do not edit.\n"
+         " */\n"
+         "template<>\n"
+         "struct MoveStatistics<7, 6> {\n"
+         "    static const int SCALE = 64;\n"
+         "    static const int PATTERNS = " << PATTERNS << ";\n\n"
+         "    static int rate(int pattern, int cell) {\n"
+         "        static constexpr int8_t rates[PATTERNS][7 * 6] = {\n";
+  for(int p = 0; p < PATTERNS; p++) {
+    out << "            {";
+    for(int c = 0; c < Position::WIDTH * Position::HEIGHT; c++) {
+      const unsigned long long playable = counts.playable[p][c];
+      const int rate = playable ? int(counts.best[p][c] * (MoveStatistics<Position::WIDTH, Position::HEIGHT>::SCALE - 1) / playable) : 0;
+      out << (c ? (c % Position::HEIGHT ? ", " : ",  ") : "") << rate;
+    }
+    out << "}" << (p + 1 < PATTERNS ? "," : "") << "\n";
+  }
+  out << "        };\n"
+         "        return rates[pattern < PATTERNS ? pattern : PATTERNS - 1][cell];\n"
+         "    }\n"
+         "};\n\n"
+         "} // namespace Connect4\n"
+         "} // namespace GameSolver\n"
+         "#endif\n";
+}
+
+/**
+ * Mine the three books of the application and the self-play games of the standard input, one game per line.
+ */
+void generate_move_statistics() {
+  std::vector<std::string> games;
+  std::string line;
+  while(std::getline(std::cin, line)) games.push_back(line);
+
+  MoveStatisticsCounts counts;
+  std::srand(0);
+  for(const char *file : {"7x6_mini.book", "7x6_small.book", "7x6.book"}) {
+    OpeningBook book{Position::WIDTH, Position::HEIGHT};
+    book.load(file);
+    sample_book(book, 100000, counts);
+    count_games(games, book, counts);
+  }
+  print_move_statistics(counts, std::cout);
+}
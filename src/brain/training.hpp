@@ -0,0 +1,187 @@
+#include "Position.hpp"
+#include "OpeningBook.hpp"
+#include "Evaluator.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace GameSolver::Connect4;
+
+/**
+ * Offline tool training the weights of Evaluator.
+ *
+ * The evaluation is a logistic regression of the outcome of a position for the player to move:
+ * a win counts 1, a draw 1/2 and a loss 0.
+ * Positions are sampled by random games played down to the depth of the opening books, the outcome being
+ * the one stored in the book, and read from self-play logs: one game per line, as a sequence of 0-based columns
+ * (see Position::playSeq), the outcome of every position of the game being the end of the game.
+ * The weights are printed as the EvaluatorWeights.hpp header read by Evaluator.
+ */
+static constexpr int TRAINING_FEATURES = Evaluator::FEATURES + 1; // the last one is the bias, always 1
+
+struct TrainingSample {
+  double features[TRAINING_FEATURES];
+  double outcome;
+};
+
+static void add_sample(const Position &P, double outcome, std::vector<TrainingSample> &samples) {
+  TrainingSample sample;
+  int features[Evaluator::FEATURES];
+  Evaluator::features(P, features);
+  for(int i = 0; i < Evaluator::FEATURES; i++) sample.features[i] = features[i];
+  sample.features[Evaluator::FEATURES] = 1;
+  sample.outcome = outcome;
+  samples.push_back(sample);
+}
+
+/**
+ * Play random games down to the depth of the book, adding every position scored by the book.
+ */
+void sample_book_outcomes(const OpeningBook &book, int games, std::vector<TrainingSample> &samples) {
+  std::unordered_set<uint64_t> visited;
+  for(int game = 0; game < games; game++) {
+    Position P;
+    while(P.nbMoves() <= book.getDepth() && !P.canWinNext()) {
+      const uint64_t key = P.key3();
+      if(!visited.count(key)) {
+        visited.insert(key);
+        if(int val = book.get(P)) {
+          const int score = val + Position::MIN_SCORE - 1;
+          add_sample(P, score > 0 ? 1 : score < 0 ? 0 : 0.5, samples);
+        }
+      }
+      const Position::bitboard_t moves = P.possibleNonLosingMoves();
+      if(!moves) break;
+      int col;
+      do col = std::rand() % Position::WIDTH; while(!(moves & Position::column_mask(col)));
+      P.playCol(col);
+    }
+  }
+}
+
+/**
+ * Add the positions of self-play games, games without an end are skipped.
+ */
+void add_games(const std::vector<std::string> &games, std::vector<TrainingSample> &samples) {
+  for(const std::string &line : games) {
+    std::vector<Position> positions;
+    Position P;
+    int winner = -1; // parity of the number of moves of the winning position, -1 if none
+    for(char c : line) {
+      const int col = c - '0';
+      if(col < 0 || col >= Position::WIDTH || !P.canPlay(col)) break;
+      if(P.isWinningMove(col)) {
+        winner = P.nbMoves() & 1;
+        break;
+      }
+      positions.push_back(P);
+      P.playCol(col);
+    }
+    const bool draw = winner < 0 && P.nbMoves() == Position::WIDTH * Position::HEIGHT;
+    if(winner < 0 && !draw) continue;
+
+    for(const Position &position : positions)
+      add_sample(position, draw ? 0.5 : (position.nbMoves() & 1) == winner ? 1 : 0, samples);
+  }
+}
+
+/**
+ * Fit the weights by gradient descent on the log loss.
+ */
+void fit_weights(const std::vector<TrainingSample> &samples, double weights[TRAINING_FEATURES]) {
+  // scale the features to comparable ranges for the descent
+  double scale[TRAINING_FEATURES];
+  for(int i = 0; i < TRAINING_FEATURES; i++) {
+    double max = 1;
+    for(const TrainingSample &sample : samples) max = std::max(max, sample.features[i]);
+    scale[i] = 1 / max;
+    weights[i] = 0;
+  }
+
+  const double rate = 1.0;
+  for(int epoch = 0; epoch < 2000; epoch++) {
+    double gradient[TRAINING_FEATURES] = {};
+    for(const TrainingSample &sample : samples) {
+      double logit = 0;
+      for(int i = 0; i < TRAINING_FEATURES; i++) logit += weights[i] * sample.features[i] * scale[i];
+      const double error = 1 / (1 + std::exp(-logit)) - sample.outcome;
+      for(int i = 0; i < TRAINING_FEATURES; i++) gradient[i] += error * sample.features[i] * scale[i];
+    }
+    for(int i = 0; i < TRAINING_FEATURES; i++) weights[i] -= rate * gradient[i] / samples.size();
+  }
+
+  for(int i = 0; i < TRAINING_FEATURES; i++) weights[i] *= scale[i];
+}
+
+/**
+ * Print the EvaluatorWeights.hpp header for the weights.
+ */
+void print_evaluator_weights(const double weights[TRAINING_FEATURES], size_t samples, std::ostream &out) {
+  typedef EvaluatorWeights<Position::WIDTH, Position::HEIGHT, Position::FOUR> weights_t;
+  out << "#ifndef EVALUATOR_WEIGHTS_HPP\n"
+         "#define EVALUATOR_WEIGHTS_HPP\n\n"
+         "#include <cstdint>\n\n"
+         "namespace GameSolver {\n"
+         "namespace Connect4 {\n\n"
+         "/**\n"
+         " * Weights of the features of Evaluator, in 1/UNIT of logit, the last one being the bias.\n"
+         " * The evaluation grows by one every STEP units.\n"
+         " * No weights are trained for this game: every position is evaluated 0.\n"
+         " */\n"
+         "template<int W, int H, int N>\n"
+         "struct EvaluatorWeights {\n"
+         "    static const bool TRAINED = false;\n"
+         "    static const int FEATURES = 2 * (N - 1) + 4;\n"
+         "    static const int UNIT = " << weights_t::UNIT << ";\n"
+         "    static const int STEP = " << weights_t::STEP << ";\n\n"
+         "    static int weight(int) {\n"
+         "        return 0;\n"
+         "    }\n"
+         "};\n\n"
+         "/**\n"
+         " * Weights of the classic game, generated by training.hpp from " << samples << " positions, do not edit.\n"
+         " */\n"
+         "template<>\n"
+         "struct EvaluatorWeights<7, 6, 4> {\n"
+         "    static const bool TRAINED = true;\n"
+         "    static const int FEATURES = " << Evaluator::FEATURES << ";\n"
+         "    static const int UNIT = " << weights_t::UNIT << ";\n"
+         "    static const int STEP = " << weights_t::STEP << ";\n\n"
+         "    static int weight(int feature) {\n"
+         "        static constexpr int16_t weights[FEATURES + 1] = {";
+  for(int i = 0; i < TRAINING_FEATURES; i++)
+    out << (i ? ", " : "") << int(std::lround(weights[i] * weights_t::UNIT));
+  out << "};\n"
+         "        return weights[feature];\n"
+         "    }\n"
+         "};\n\n"
+         "} // namespace Connect4\n"
+         "} // namespace GameSolver\n"
+         "#endif\n";
+}
+
+/**
+ * Train on the two largest books of the application and the self-play games of the standard input, one game per line.
+ */
+void train_evaluator() {
+  std::vector<std::string> games;
+  std::string line;
+  while(std::getline(std::cin, line)) games.push_back(line);
+
+  std::vector<TrainingSample> samples;
+  std::srand(0);
+  for(const char *file : {"7x6_small.book", "7x6.book"}) {
+    OpeningBook book{Position::WIDTH, Position::HEIGHT};
+    book.load(file);
+    sample_book_outcomes(book, 20000, samples);
+  }
+  add_games(games, samples);
+
+  double weights[TRAINING_FEATURES];
+  fit_weights(samples, weights);
+  print_evaluator_weights(weights, samples.size(), std::cout);
+}
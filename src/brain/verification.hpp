@@ -0,0 +1,101 @@
+#include "Position.hpp"
+#include "Solver.hpp"
+#include "ThreatOracle.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace GameSolver::Connect4;
+
+/**
+ * Offline tool checking the bounds of the threat oracle against a brute force search.
+ *
+ * Positions are sampled by random games stopped a few empty cells before the end, on boards of even
+ * and odd height, and every bound proven by the oracle is checked by a plain alpha-beta search
+ * without any of the knowledge of the solver. The known counter examples are checked as well.
+ */
+
+/**
+ * Plain negamax, same scores as the solver.
+ */
+template<class position_t>
+int brute_force(const position_t &P, int alpha, int beta) {
+  const int size = position_t::WIDTH * position_t::HEIGHT;
+  if(P.nbMoves() == size) return 0;
+  for(int col = 0; col < position_t::WIDTH; col++)
+    if(P.canPlay(col) && P.isWinningMove(col)) return (size + 1 - P.nbMoves()) / 2;
+
+  const int max = (size - 1 - P.nbMoves()) / 2;
+  if(beta > max) {
+    beta = max;
+    if(alpha >= beta) return beta;
+  }
+  for(int col = 0; col < position_t::WIDTH; col++) {
+    if(!P.canPlay(col)) continue;
+    position_t P2(P);
+    P2.playCol(col);
+    const int score = -brute_force(P2, -beta, -alpha);
+    if(score >= beta) return score;
+    if(score > alpha) alpha = score;
+  }
+  return alpha;
+}
+
+/**
+ * Check the oracle on random positions with the given number of empty cells.
+ * @return the number of unsound bounds.
+ */
+template<class position_t>
+int verify_threat_oracle(int positions, int empty) {
+  typedef BasicThreatOracle<position_t> oracle_t;
+  int bounded = 0, unsound = 0;
+  for(int i = 0; i < positions; i++) {
+    position_t P;
+    std::string seq;
+    while(P.nbMoves() < position_t::WIDTH * position_t::HEIGHT - empty) {
+      const int col = std::rand() % position_t::WIDTH;
+      if(!P.canPlay(col) || P.isWinningMove(col)) {
+        bool playable = false;
+        for(int c = 0; c < position_t::WIDTH; c++) playable |= P.canPlay(c) && !P.isWinningMove(c);
+        if(!playable) break;
+        continue;
+      }
+      P.playCol(col);
+      seq += char('0' + col);
+    }
+    if(P.canWinNext()) continue;
+
+    const int bound = oracle_t::upperBound(P);
+    if(bound >= oracle_t::NO_BOUND) continue;
+    bounded++;
+    if(brute_force(P, bound, bound + 1) > bound) {
+      unsound++;
+      std::cerr << position_t::WIDTH << "x" << position_t::HEIGHT << " " << seq << ": bound " << bound << " is unsound\n";
+    }
+  }
+  std::cout << position_t::WIDTH << "x" << position_t::HEIGHT << ": " << bounded << " bounds, " << unsound << " unsound\n";
+  return unsound;
+}
+
+/**
+ * Check the oracle on small boards of even and odd height and the solver on a known counter example.
+ * @return the number of failures.
+ */
+int verify() {
+  std::srand(0);
+  int failures = 0;
+  failures += verify_threat_oracle<BasicPosition<6, 6, 4>>(5000, 12);
+  failures += verify_threat_oracle<BasicPosition<7, 6, 4>>(5000, 12);
+  failures += verify_threat_oracle<BasicPosition<5, 5, 4>>(5000, 12);
+  failures += verify_threat_oracle<BasicPosition<6, 5, 4>>(5000, 12);
+
+  // forced win for the player to move, once solved as a draw by the claimeven rule on a board of odd height
+  std::unique_ptr<BoardSolver> solver{BoardSolver::create(8, 7, 4)};
+  if(solver && solver->solve("043111611531567675126576653423624743332055", -1, false) <= 0) {
+    std::cerr << "8x7 043111611531567675126576653423624743332055: not solved as a win\n";
+    failures++;
+  }
+  return failures;
+}
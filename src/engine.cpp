@@ -0,0 +1,259 @@
+#include "engine.hpp"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+Engine::Engine(QObject *parent)
+    : QObject(parent),
+      policy{EnginePolicy::fromSettings()}
+{
+    pool.setMaxThreadCount(1); // a single thread: messages are processed in order
+    pool.setExpiryTimeout(-1); // never let the engine thread expire, the transposition table stays hot on its core
+
+    qRegisterMetaType<QVector<int>>(); // queued through analysisDone
+}
+
+Engine::~Engine() {
+    pool.waitForDone();
+}
+
+template<class Message>
+void Engine::post(Message message) {
+    QtConcurrent::run(&pool, [this, message]() {
+        static thread_local bool policyApplied = false;
+        if (!policyApplied) {
+            policy.applyToCurrentThread();
+            policyApplied = true;
+        }
+
+        message();
+    });
+}
+
+void Engine::setLevel(Level level) {
+    interruptWarmUp();
+    post([this, level]() {
+        switch(level) {
+        case Level::Easy:
+            // a small fixed budget: weak but natural play
+            solver.clearBook();
+            mcts.setBudget({200, 1 << 12, 1, 1.4, true});
+            depth = 4; // only used by the analysis
+            useMcts = true;
+            break;
+        case Level::Normal:
+            solver.loadBook("7x6_mini.book");
+            depth = 38; // forced lines are extended, as deep as 40 plies without extensions
+            useMcts = false;
+            break;
+        case Level::Hard:
+            solver.loadBook("7x6_small.book");
+            depth = 14; // positions at the horizon are evaluated, as good as 18 plies without evaluation
+            useMcts = false;
+            break;
+        case Level::Expert:
+            solver.loadBook("7x6.book");
+            depth = -1;
+            useMcts = false;
+            break;
+        default :
+            assert(false && "Undefined level");
+        }
+    });
+}
+
+void Engine::warmUp() {
+    if (!policy.warmUp) {
+        return;
+    }
+
+    warming = true;
+    post([this]() {
+        if (!useMcts && warming) {
+            // a thread of its own at idle priority, the engine thread keeps its policy for the following requests
+            std::thread idleThread([this]() {
+                EnginePolicy idle = policy;
+                idle.scheduler = EnginePolicy::Scheduler::Idle;
+                idle.applyToCurrentThread();
+                runWarmUp();
+            });
+            idleThread.join();
+        }
+
+        std::lock_guard<std::mutex> lock(warmUpMutex);
+        warming = false;
+        solver.clearStop();
+    });
+}
+
+void Engine::interruptWarmUp() {
+    std::lock_guard<std::mutex> lock(warmUpMutex);
+    if (warming) {
+        warming = false;
+        solver.stop(); // the warm-up ends at once, then clears the stop
+    }
+}
+
+void Engine::runWarmUp() {
+    if (!solver.inBook(Position())) {
+        return; // no book: nothing is cheap to reach
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+    int analysed = 0;
+    for (int line = 0; line < WARM_UP_LINES && warming; line++) {
+        // both sides play one of the best moves, chosen at random: the lines a strong opponent is likely to follow
+        Position position;
+        bool over = false;
+        while (solver.inBook(position) && !over && warming) {
+            const int column = solver.getBestMove(position, depth);
+            if (column < 0) {
+                over = true;
+            } else {
+                over = position.isWinningMove(column);
+                position.playCol(column);
+            }
+        }
+
+        if (!over && warming) {
+            solver.analyze(position, depth);
+            analysed++;
+        }
+    }
+
+    qDebug() << "warm-up analysed" << analysed << "positions in" << clock.elapsed() << "ms" << (warming ? "" : "(interrupted)");
+}
+
+Solver::Line Engine::portfolioBestLine(const Position &position) {
+    prover.clearStop();
+
+    std::atomic<int> winningColumn{-1};
+    std::thread proverThread([this, &position, &winningColumn]() {
+        policy.applyToHelperThread(); // not on the cpu of the solver it races
+        int column = prover.getWinningMove(position);
+        if (column >= 0) {
+            winningColumn = column;
+            solver.stop();
+        }
+    });
+
+    Solver::Line line = solver.getBestLine(position, depth);
+    prover.stop();
+    proverThread.join();
+    solver.clearStop(); // the prover may have stopped the solver after its answer
+
+    if (winningColumn >= 0 && line.column < 0) { // the solver was stopped, a complete solver line is the fastest win
+        qDebug() << "proof-number search found a win in column" << winningColumn;
+        line = Solver::Line{winningColumn, 1, {}, false}; // a win, how fast is unknown
+    }
+
+    return line;
+}
+
+Solver::Line Engine::anytimeBestLine(const Position &position, MoveBudget budget) {
+    if (budget.hard < 0 || solver.inBook(position)) { // nothing to share: a single search
+        return depth < 0 ? portfolioBestLine(position) : solver.getBestLine(position, depth);
+    }
+    if (solver.isExpected(position)) {
+        budget.soft /= 2; // the previous search expected this position, its tree is in the transposition table
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+
+    // stop the search at the hard deadline, unless it completes first
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    bool completed = false;
+    std::atomic<bool> expired{false};
+    const std::chrono::milliseconds deadline(budget.hard);
+    std::thread watchdog([this, deadline, &mutex, &wakeUp, &completed, &expired]() {
+        policy.applyToHelperThread(); // wakes up at the deadline without waiting for the cpu of the solver
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!wakeUp.wait_for(lock, deadline, [&completed]() { return completed; })) {
+            expired = true;
+            solver.stop();
+            prover.stop();
+        }
+    });
+
+    const int empty = Position::WIDTH * Position::HEIGHT - position.nbMoves();
+    const int limit = depth < 0 ? empty : depth; // a depth reaching the end of the game is the exact search
+    Solver::Line best{-1, 0, {}, false};
+    for (int iteration = 2; ; iteration *= 2) {
+        const bool last = iteration >= limit;
+        const Solver::Line line = last && depth < 0 ? portfolioBestLine(position)
+                                                    : solver.getBestLine(position, last ? depth : iteration);
+        if (line.column < 0) { // stopped: the iteration is not complete
+            qDebug() << "search stopped after" << clock.elapsed() << "ms, depth" << iteration / 2;
+            break;
+        }
+
+        if (line.score == Solver::Line::UNKNOWN) { // a forced move, played without search at any depth
+            best = line;
+            break;
+        }
+        if (best.column >= 0 && line.score != best.score) { // unstable score: worth looking deeper
+            budget.soft = std::min(budget.hard, budget.soft * 3 / 2);
+        }
+        best = line;
+        if (expired || last || clock.elapsed() >= budget.soft) { // an iteration completed at the deadline is kept
+            break;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        completed = true;
+    }
+    wakeUp.notify_one();
+    watchdog.join();
+    solver.clearStop();
+
+    if (best.column < 0) { // not even the first iteration: any non losing move
+        best = solver.getBestLine(position, 0);
+    }
+    return best;
+}
+
+void Engine::search(quint64 id, const Position &position, MoveBudget budget) {
+    interruptWarmUp();
+    post([this, id, position, budget]() {
+        Solver::Line line{-1, 0, {}, false};
+        if (useMcts) {
+            line.column = mcts.getBestMove(position);
+        } else {
+            line = anytimeBestLine(position, budget);
+        }
+        emit searchDone(id, line.column);
+
+        if (!line.pv.empty() && line.score != Solver::Line::UNKNOWN) {
+            emit lineFound(id, line.score, QVector<int>(line.pv.begin(), line.pv.end()), line.evaluated);
+        }
+    });
+}
+
+void Engine::analyze(quint64 id, const Position &position) {
+    interruptWarmUp();
+    post([this, id, position]() {
+        const bool exact = depth < 0;
+        Solver::Analysis analysis = solver.analyze(position, depth, false, [this, id, exact](int column, int score) {
+            emit columnAnalyzed(id, column, score, exact);
+        });
+
+        QVector<int> scores;
+        for (int column = 0; column < Position::WIDTH; column++) {
+            scores.append(analysis.scores[column]);
+        }
+        emit analysisDone(id, scores, analysis.exact);
+    });
+}
@@ -0,0 +1,160 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QVector>
+
+#include <atomic>
+#include <mutex>
+
+// include custom classes
+#include "enginepolicy.hpp"
+#include "levelclass.hpp"
+#include "timemanager.hpp"
+#include "brain/MCTS.hpp"
+#include "brain/Position.hpp"
+#include "brain/ProofNumberSearch.hpp"
+#include "brain/Solver.hpp"
+
+using namespace GameSolver::Connect4;
+
+/**
+ * The AI engine, run as an actor on its own thread.
+ *
+ * Every request is posted as a message to a single engine thread and carries
+ * its own copy of the position, so the engine never touches the game board.
+ * Messages are processed in order, the solver and its transposition table are
+ * only ever accessed from the engine thread.
+ * Results come back as signals, delivered on the thread the engine lives in.
+ */
+class Engine : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit Engine(QObject *parent = nullptr);
+    ~Engine();
+
+    /**
+     * Set the level of AI.
+     * The change applies to every search posted after this call.
+     */
+    void setLevel(Level level);
+
+    /**
+     * Post a search request.
+     * The method returns immediately, searchDone is emitted when the best move is known.
+     * A limited search deepens iteratively and plays the move of its last complete iteration (anytime search),
+     * positions of the opening book are searched at once.
+     *
+     * @param id: an identifier of the request, returned with the result
+     * @param position: a snapshot of the position to search
+     * @param budget: the time allowed to the search, unlimited by default
+     */
+    void search(quint64 id, const Position &position, MoveBudget budget = MoveBudget());
+
+    /**
+     * Post a warm-up of the transposition table, to be called once at startup.
+     * A few likely openings are played from the opening book, the position reached just beyond the book
+     * is analysed at the depth of the level. The warm-up runs at idle priority and stops as soon as
+     * another request is posted. It is skipped if the policy disables it or if the level does not use the solver.
+     */
+    void warmUp();
+
+    /**
+     * Post an analysis request: the score of every column, computed with the solver at the depth of the level.
+     * The method returns immediately, columnAnalyzed is emitted for each column as soon as its score is known,
+     * then analysisDone once every column is scored.
+     * Analysing the position the engine just searched, or analysing twice, does not search again.
+     *
+     * @param id: an identifier of the request, returned with the result
+     * @param position: a snapshot of the position to analyse
+     */
+    void analyze(quint64 id, const Position &position);
+
+signals:
+    /**
+     * Emited when a search request is completed.
+     * @param id: the identifier given to search
+     * @param column: the best column to play, -1 if no move is allowed
+     */
+    void searchDone(quint64 id, int column);
+
+    /**
+     * Emited after searchDone when the solver made the move, with the line it expects.
+     * @param id: the identifier given to search
+     * @param score: the score of the move for the player to move
+     * @param pv: the expected columns, starting with the chosen one
+     * @param evaluated: true if the outcome of the score, win, draw or loss, rests on an evaluation at the horizon
+     */
+    void lineFound(quint64 id, int score, QVector<int> pv, bool evaluated);
+
+    /**
+     * Emited during an analysis request each time the score of a column is known,
+     * before analysisDone.
+     * @param id: the identifier given to analyze
+     * @param column: the analysed column
+     * @param score: its score for the player to move
+     * @param exact: false if the score is only bounded by the depth of the search
+     */
+    void columnAnalyzed(quint64 id, int column, int score, bool exact);
+
+    /**
+     * Emited when an analysis request is completed.
+     * @param id: the identifier given to analyze
+     * @param scores: the score of each column for the player to move, Solver::Analysis::INVALID if not playable
+     * @param exact: false if the scores are only bounded by the depth of the search
+     */
+    void analysisDone(quint64 id, QVector<int> scores, bool exact);
+
+private:
+    // Everything below is owned by the engine thread once the engine is built
+    Solver solver;
+    ProofNumberSearch prover;
+    MCTS mcts;
+    int depth = 4;
+    bool useMcts = true; // search with MCTS instead of the solver
+
+    QThreadPool pool;
+    EnginePolicy policy;
+
+    static const int WARM_UP_LINES = 16; // openings analysed by the warm-up
+
+    // Set while a warm-up is pending or running, cleared by the first following request.
+    // The mutex orders stopping the solver for the warm-up with clearing the stop at its end.
+    std::mutex warmUpMutex;
+    std::atomic<bool> warming{false};
+
+    /**
+     * Stop the warm-up, if any, called from the thread posting a request.
+     */
+    void interruptWarmUp();
+
+    /**
+     * Play likely openings up to the end of the book and analyse the positions reached,
+     * until the lines are exhausted or the warm-up is interrupted.
+     */
+    void runWarmUp();
+
+    /**
+     * Run the solver and the proof-number search side by side, the first to answer wins.
+     * The proof-number search can only answer when the position is won.
+     */
+    Solver::Line portfolioBestLine(const Position &position);
+
+    /**
+     * Search the position at increasing depths until the budget is spent, up to the depth of the level.
+     * The soft budget grows when the score changes between two iterations.
+     * @return the line of the last complete iteration
+     */
+    Solver::Line anytimeBestLine(const Position &position, MoveBudget budget);
+
+    /**
+     * Run a message on the engine thread.
+     */
+    template<class Message>
+    void post(Message message);
+};
+
+#endif // ENGINE_H
@@ -0,0 +1,104 @@
+#include "enginepolicy.hpp"
+
+#include <QDebug>
+#include <QSettings>
+#include <QThread>
+
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+EnginePolicy EnginePolicy::fromSettings() {
+    EnginePolicy policy;
+
+    QSettings settings;
+    settings.beginGroup("engine");
+    policy.niceness = settings.value("niceness", policy.niceness).toInt();
+    policy.scheduler = schedulerFromString(settings.value("scheduler", "batch").toString());
+    policy.cpu = settings.value("cpu", policy.cpu).toInt();
+    policy.warmUp = settings.value("warmUp", policy.warmUp).toBool();
+    settings.endGroup();
+
+    return policy;
+}
+
+EnginePolicy::Scheduler EnginePolicy::schedulerFromString(const QString &name) {
+    if (name == "idle") {
+        return Scheduler::Idle;
+    } else if (name == "normal") {
+        return Scheduler::Normal;
+    } else {
+        return Scheduler::Batch;
+    }
+}
+
+void EnginePolicy::applyToCurrentThread() const {
+#ifdef Q_OS_LINUX
+    sched_param param{};
+    int policy = SCHED_OTHER;
+    switch (scheduler) {
+    case Scheduler::Batch:
+        policy = SCHED_BATCH;
+        break;
+    case Scheduler::Idle:
+        policy = SCHED_IDLE;
+        break;
+    default:
+        break;
+    }
+    if (pthread_setschedparam(pthread_self(), policy, &param) != 0) {
+        qWarning() << "EnginePolicy: unable to set the scheduler policy";
+    }
+
+    // On Linux the nice value is a per-thread attribute
+    if (niceness != 0 && setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), niceness) != 0) {
+        qWarning() << "EnginePolicy: unable to set niceness" << niceness;
+    }
+
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+            qWarning() << "EnginePolicy: unable to pin the engine thread on cpu" << cpu;
+        }
+    }
+#else
+    switch (scheduler) {
+    case Scheduler::Batch:
+        QThread::currentThread()->setPriority(QThread::LowPriority);
+        break;
+    case Scheduler::Idle:
+        QThread::currentThread()->setPriority(QThread::IdlePriority);
+        break;
+    default:
+        break;
+    }
+#endif
+}
+
+void EnginePolicy::applyToHelperThread() const {
+    EnginePolicy helper = *this;
+    helper.cpu = -1;
+    helper.applyToCurrentThread();
+
+#ifdef Q_OS_LINUX
+    // a new thread inherits the affinity of the engine thread: start again from the cpus allowed to the process
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(getpid(), sizeof(set), &set) != 0) {
+        qWarning() << "EnginePolicy: unable to read the affinity of the process";
+        return;
+    }
+    if (cpu >= 0 && CPU_ISSET(cpu, &set) && CPU_COUNT(&set) > 1) {
+        CPU_CLR(cpu, &set); // leave the cpu of the engine thread to the engine
+    }
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        qWarning() << "EnginePolicy: unable to set the affinity of a helper thread";
+    }
+#endif
+}
@@ -0,0 +1,56 @@
+#ifndef ENGINEPOLICY_H
+#define ENGINEPOLICY_H
+
+#include <QString>
+#include <QtGlobal>
+
+/**
+ * Scheduling policy of the thread running the AI search.
+ *
+ * The policy is read from the application settings (group "engine"):
+ * - niceness:  nice value of the engine thread (Linux only), 0 keeps the default
+ * - scheduler: "normal", "batch" or "idle" (SCHED_OTHER, SCHED_BATCH, SCHED_IDLE on Linux)
+ * - cpu:       0-based index of the cpu the engine thread is pinned on, -1 for no affinity
+ * - warmUp:    warm the transposition table up at startup, off by default on mobile platforms to save the battery
+ */
+class EnginePolicy
+{
+public:
+    enum class Scheduler {
+        Normal,
+        Batch,
+        Idle
+    };
+
+    int niceness = 5;
+    Scheduler scheduler = Scheduler::Batch;
+    int cpu = -1;
+#if defined(Q_OS_ANDROID) || defined(Q_OS_IOS)
+    bool warmUp = false;
+#else
+    bool warmUp = true;
+#endif
+
+    /**
+     * Read the policy from the application settings, missing keys keep their default value.
+     */
+    static EnginePolicy fromSettings();
+
+    /**
+     * Apply the policy to the calling thread.
+     * Failures are only logged, the search still runs with the default scheduling.
+     */
+    void applyToCurrentThread() const;
+
+    /**
+     * Apply the policy to a thread started by the engine thread to run beside it, as the proof-number search:
+     * the scheduler and niceness of the engine, but not its cpu, the thread may run on any other cpu of the process.
+     * Failures are only logged.
+     */
+    void applyToHelperThread() const;
+
+private:
+    static Scheduler schedulerFromString(const QString &name);
+};
+
+#endif // ENGINEPOLICY_H
@@ -1,120 +1,194 @@
 #include "gamemodel.hpp"
 
 #include <QDebug>
-#include <QtConcurrent>
-#include <chrono>
-#include <thread>
+#include <QStringList>
+
+#include <algorithm>
 
 GameModel::GameModel()
+    : time{TimeManager::fromSettings()}
 {
-    // perform custom initialization steps here
+    connect(&engine, &Engine::searchDone, this, &GameModel::searchDone);
+    connect(&engine, &Engine::lineFound, this, &GameModel::lineReady);
+    connect(&engine, &Engine::columnAnalyzed, this, &GameModel::columnAnalyzed);
+    connect(&engine, &Engine::analysisDone, this, &GameModel::analysisReady);
+
+    analysisTimer.setSingleShot(true);
+    analysisTimer.setInterval(16); // a frame at 60 Hz
+    connect(&analysisTimer, &QTimer::timeout, this, &GameModel::flushAnalysis);
+}
+
+void GameModel::warmUp() {
+    engine.warmUp();
+}
+
+int GameModel::state() const {
+    return gameState;
+}
+
+void GameModel::setState(MoveResult::State state) {
+    if (state != gameState) {
+        gameState = state;
+        emit stateChanged();
+    }
 }
 
 void GameModel::newGame() {
     qDebug() << "GameModel newGame";
 
     board = Position();
+    setState(MoveResult::Playing);
+    time.newGame();
+    ++searchId; // drop the result of a pending search
+    ++analysisId;
+    analysisTimer.stop();
 }
 
 bool GameModel::canPlay(int column) {
     //qDebug() << "GameModel canPlay " << column;
 
-    if (column < 0 || column > COLUMNS) {
+    if (column < 0 || column >= COLUMNS) {
         return false;
     }
 
     return board.canPlay(column);
 }
 
-int GameModel::play(int column) {
-    if (!canPlay(column)) {
-        return -1;
+MoveResult GameModel::commitMove(int column) {
+    if (gameState != MoveResult::Playing || !canPlay(column)) {
+        return MoveResult{column, -1, 0, gameState, 0};
     }
 
-    return board.playCol(column);
-}
+    ++analysisId; // a pending analysis is about the previous position
+    analysisTimer.stop();
+    const int row = board.playCol(column);
+    const int player = board.lastPlayer();
+    const MoveResult::State state = static_cast<MoveResult::State>(board.whoWin());
+
+    quint64 winningCells = 0;
+    if (state == MoveResult::FirstPlayerWins || state == MoveResult::SecondPlayerWins) {
+        for (Move move : board.getWinningPosition()) {
+            winningCells |= quint64(1) << (move.column * ROWS + move.row);
+        }
+    }
 
-int GameModel::lastPlayer() {
-    return board.lastPlayer();
+    setState(state);
+    return MoveResult{column, row, player, state, winningCells};
 }
 
 void GameModel::chooseMove() {
+    searchClock.start();
+    engine.search(++searchId, board, time.moveBudget(board));
+}
+
+void GameModel::searchDone(quint64 id, int column) {
+    if (id != searchId) {
+        return; // the game changed while the engine was searching
+    }
+
+    time.spent(searchClock.elapsed());
+
+    emit moveChoosed(commitMove(column)); // an invalid column is not played
+}
+
+void GameModel::lineReady(quint64 id, int score, QVector<int> pv, bool evaluated) {
+    if (id != searchId) {
+        return;
+    }
 
-    auto *watcher = new QFutureWatcher<Move>(this);
+    QStringList columns;
+    for (int column : pv) {
+        columns.append(QString::number(column + 1));
+    }
 
-    watcher->setFuture(QtConcurrent::run(this, &GameModel::chooseMove_blocking));
+    // the search was done before the move: the model played board.nbMoves() - 1
+    const int nbMoves = board.nbMoves() - 1;
+    QString line = columns.join("-");
+    if (evaluated) { // an advantage at the horizon, not proven
+        if (score != 0) {
+            line = QString("%1: %2").arg(score > 0 ? "ahead" : "behind").arg(line);
+        }
+    } else if (!reachesEnd(pv)) {
+        // the outcome is only told with the moves leading to it
+    } else if (score > 0) {
+        const int moves = (COLUMNS * ROWS + 1 - 2 * score - nbMoves) / 2 + 1; // own moves up to the winning one
+        line = QString("win in %1: %2").arg(moves).arg(line);
+    } else if (score < 0) {
+        const int moves = (COLUMNS * ROWS + 2 + 2 * score - nbMoves) / 2; // own moves before the opponent wins
+        line = QString("loss in %1: %2").arg(moves).arg(line);
+    } else {
+        line = QString("draw: %1").arg(line);
+    }
 
-    QObject::connect(watcher, &QFutureWatcher<Move>::finished,
-                     this, [this,watcher]() {
-        Move  move = watcher->result();
-        emit moveChoosed(move.toJSon());
-        watcher->deleteLater();
-    });
+    emit lineFound(line);
 }
 
-Move GameModel::chooseMove_blocking() {
-    //qDebug() << "GameModel chooseMove ";
+bool GameModel::reachesEnd(const QVector<int> &pv) {
+    if (pv.size() == 1) {
+        return board.whoWin() >= 0; // the move of the model ended the game
+    }
 
-    // int columns[]{3, 2, 4, 1, 5, 0, 6};
-    // int column = -1;
-    //
-    // for(int i = 0; i < 7; i++) {
-    //     //qDebug() << "i: " << i << " columns[i]: " << columns[i] << " canPlay: " << canPlay(columns[i]);
-    //     if (canPlay(columns[i])) {
-    //         column = columns[i];
-    //         break;
-    //     }
-    // }
-    // std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    Position P(board); // the move of the model, the first of the line, is already played
+    for (int i = 1; i < pv.size(); i++) {
+        if (pv[i] < 0 || pv[i] >= COLUMNS || !P.canPlay(pv[i])) {
+            return false;
+        }
+        if (P.isWinningMove(pv[i])) {
+            return i == pv.size() - 1;
+        }
+        P.playCol(pv[i]);
+    }
+    return P.nbMoves() == COLUMNS * ROWS; // draw game
+}
 
-    qDebug() << "going to sleep";
-    int column = solver.getBestMove(board, depth);
-    qDebug() << "awake";
+void GameModel::analyze() {
+    partialScores.fill(int(Solver::Analysis::INVALID), COLUMNS); // a copy, fill takes a reference
+    analysisTimer.stop();
+    engine.analyze(++analysisId, board);
+}
 
-    int row = play(column);
-    //qDebug() << "column: " << column << " row: " << row;
+void GameModel::columnAnalyzed(quint64 id, int column, int score, bool exact) {
+    if (id != analysisId) {
+        return;
+    }
 
-    return Move{column, row};
+    partialScores[column] = score;
+    partialExact = exact;
+    if (!analysisTimer.isActive()) {
+        analysisTimer.start(); // the following columns of the frame are sent together
+    }
 }
 
-int GameModel::whoWin() {
-    return board.whoWin();
+void GameModel::flushAnalysis() {
+    emit analysisUpdated(analysisToJSon(partialScores, partialExact));
 }
 
-QVariantList GameModel::getWinningPosition() {
-    QVariantList moves{};
+void GameModel::analysisReady(quint64 id, QVector<int> scores, bool exact) {
+    if (id != analysisId) {
+        return;
+    }
 
-    std::array<Move, Position::FOUR> arr = board.getWinningPosition();
+    analysisTimer.stop(); // the complete analysis supersedes the pending update
+    emit analysisDone(analysisToJSon(scores, exact));
+}
 
-    for (Move move : arr) {
-        moves.append(move.toJSon());
+QJsonObject GameModel::analysisToJSon(const QVector<int> &scores, bool exact) {
+    QJsonArray columns;
+    int score = Solver::Analysis::INVALID;
+    for (int columnScore : scores) {
+        columns.append(columnScore == Solver::Analysis::INVALID ? QJsonValue() : QJsonValue(columnScore));
+        score = std::max(score, columnScore);
     }
 
-    return moves;
+    QJsonObject analysis;
+    analysis.insert("scores", columns);
+    analysis.insert("score", score == Solver::Analysis::INVALID ? QJsonValue() : QJsonValue(score));
+    analysis.insert("exact", exact);
+    return analysis;
 }
 
 void GameModel::setLevel(Level level) {
     // std::cerr << "setLevel " << level << "\n";
 
-    switch(level) {
-    case Level::Easy:
-        solver.clearBook();
-        depth = 4;
-        break;
-    case Level::Normal:
-        solver.loadBook("7x6_mini.book");
-        depth = 40;
-        break;
-    case Level::Hard:
-        solver.loadBook("7x6_small.book");
-        depth = 20;
-        break;
-    case Level::Expert:
-        solver.loadBook("7x6.book");
-        depth = -1;
-        break;
-    default :
-        assert(false && "Undefined level");
-    }
+    engine.setLevel(level);
 }
-
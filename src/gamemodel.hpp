@@ -1,16 +1,20 @@
 #ifndef GAMEMODEL_H
 #define GAMEMODEL_H
 
+#include <QElapsedTimer>
 #include <QObject>
+#include <QTimer>
 #include <QVariant>
 #include <QJsonArray>
 #include <QJsonObject>
 
 // include custom classes
+#include "engine.hpp"
 #include "levelclass.hpp"
+#include "moveresult.hpp"
+#include "timemanager.hpp"
 #include "brain/Move.hpp"
 #include "brain/Position.hpp"
-#include "brain/Solver.hpp"
 
 using namespace GameSolver::Connect4;
 
@@ -18,6 +22,7 @@ class GameModel : public QObject
 {
     Q_OBJECT
     //Q_PROPERTY(int counter READ counter WRITE setCounter NOTIFY counterChanged) // this makes counter available as a QML property
+    Q_PROPERTY(int state READ state NOTIFY stateChanged) // the state of the game, see MoveResult::State
 
 public:
     static const int COLUMNS = Position::WIDTH;  // Width of the board
@@ -25,6 +30,18 @@ public:
 
     GameModel();
 
+    /**
+     * Warm the engine up in the background, to be called once the user interface is loaded.
+     * The warm-up is interrupted by the first request of the game.
+     */
+    void warmUp();
+
+    /**
+     * Return the state of the game
+     * @return -1 nobody wins, 0 drawn (no more moves), 1 first player wins, 2 second player wins
+     */
+    int state() const;
+
 public slots: // slots are public methods available in QML
 
     /**
@@ -40,41 +57,25 @@ public slots: // slots are public methods available in QML
     bool canPlay(int column);
 
     /**
-     * Plays a playable column.
-     * This function should not be called on a non-playable column or a column making an alignment.
+     * Plays a column and returns everything the board needs to show the move, in a single call.
      *
-     * @param column: 0-based index of a playable column.
-     * @return the height of the play or -1 if the column is not playable
-     */
-    int play(int column);
-
-    /**
-     * Return the last player
-     * @return 1 first player, 2 second player
+     * @param column: 0-based index of the column to play.
+     * @return the move and the state of the game after it, the row is -1 if the column is not playable.
      */
-    int lastPlayer();
+    MoveResult commitMove(int column);
 
     /**
      * Ask the model to choose a move to play.
      * The call is asyncronous, the method returns immediately, when the model has choosen a move a signal moveChoosed is emited.
+     * The search is given a share of the time of the model for the game, see TimeManager.
      */
     void chooseMove();
 
     /**
-     * Return the current winner
-     * @return -1 nobody wins, 0 drawn (no more moves), 1 first player wins, 2 second player wins
-     */
-    int whoWin();
-
-    /**
-     * Return the alignment which cause the player victory.
-     * Should be called only after a winnig position exists.
-     * Is possible that more than a winning position exists,
-     * in that case the method returns the first found.
-     *
-     * @return an array of 4 aligned moves.
+     * Ask the model to score every column of the current position, for hints and the evaluation bar.
+     * The call is asyncronous, the method returns immediately, when the scores are known a signal analysisDone is emited.
      */
-    QVariantList getWinningPosition();
+    void analyze();
 
     /**
      * Set the level of AI
@@ -84,17 +85,72 @@ public slots: // slots are public methods available in QML
 
 signals:
     /**
-     * Emited when the model has choosed wich move to play, after a call to chooseMove.
-     * QVariant will contain a move in JSon format.
+     * Emited when the model has choosed wich move to play and played it, after a call to chooseMove.
+     * The column and the row of the move are -1 if no move can be played.
+     */
+    void moveChoosed(MoveResult move);
+
+    /**
+     * Emited when the state of the game changes: a player wins, the game is drawn or a new game starts.
+     */
+    void stateChanged();
+
+    /**
+     * Emited after moveChoosed with the line the model expects after its move,
+     * as in "win in 3: 4-3-4-4-5", columns being numbered from 1.
+     * The count is the number of moves of the model up to the end of the game.
+     * Below the depth of a search, an advantage only evaluated is reported as in "ahead: 4-3-4".
+     * An outcome is only told with a line reaching the end of the game, else the columns are given alone.
+     */
+    void lineFound(QString);
+
+    /**
+     * Emited while the model scores the columns, after a call to analyze,
+     * with the columns scored so far. Updates are batched, at most one per frame.
+     * QVariant has the same format as in analysisDone, the columns not scored yet are null.
      */
-    void moveChoosed(QVariant);
+    void analysisUpdated(QVariant);
+
+    /**
+     * Emited when the model has scored the columns, after a call to analyze.
+     * QVariant will contain the analysis in JSon format:
+     * scores (the score of each column for the player to move, null if the column is full),
+     * score (the score of the position) and exact (false if the scores are only bounded by the level).
+     * A positive score wins, a negative score loses, 0 is a draw.
+     */
+    void analysisDone(QVariant);
 
 private:
+    // The board is only read and modified on the GUI thread,
+    // the engine works on its own snapshots
     Position board;
-    Solver solver;
-    int depth;
+    MoveResult::State gameState = MoveResult::Playing;
+    Engine engine;
+
+    // Identifier of the last search request, results of older requests are dropped
+    quint64 searchId = 0;
+
+    // Time of the engine for the game, shared between its moves
+    TimeManager time;
+    QElapsedTimer searchClock;
+
+    // Identifier of the last analysis request, dropped as well once the board changes
+    quint64 analysisId = 0;
+
+    // Scores of the running analysis received so far, sent to QML when the timer expires
+    QVector<int> partialScores;
+    bool partialExact = false;
+    QTimer analysisTimer;
+
+    void setState(MoveResult::State state);
+    void searchDone(quint64 id, int column);
+    void lineReady(quint64 id, int score, QVector<int> pv, bool evaluated);
+    bool reachesEnd(const QVector<int> &pv); // the line from the position before the last move ends the game
+    void columnAnalyzed(quint64 id, int column, int score, bool exact);
+    void flushAnalysis();
+    void analysisReady(quint64 id, QVector<int> scores, bool exact);
 
-    Move chooseMove_blocking();
+    static QJsonObject analysisToJSon(const QVector<int> &scores, bool exact);
 };
 
 #endif // GAMEMODEL_H
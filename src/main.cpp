@@ -4,7 +4,6 @@
 #include <QIcon>
 // include qml context, required to add a context property
 #include <QQmlContext>
-#include <QLatin1String>
 #include <QDebug>
 #include <QMetaObject>
 #include <QDir>
@@ -50,6 +49,8 @@ int main(int argc, char *argv[])
 
     // register the Level enumeration
     qRegisterMetaType<Level>("Level");
+    // register the moves sent to QML
+    qRegisterMetaType<MoveResult>("MoveResult");
     qmlRegisterUncreatableType<LevelClass>("connect4", 1, 0, "Level", "Not creatable as it is an enum type");
 
     // Set the working dir to the application dir so that GameModel could find the opening books
@@ -63,12 +64,7 @@ int main(int argc, char *argv[])
     engine.rootContext()->setContextProperty("gamemodel", gamemodel); // the object will be available in QML with name "gamemodel"
 
     engine.load(url);
-
-    auto myElement = engine.rootObjects().first()->findChild<QObject*>(QLatin1String("board"));
-    //qDebug() << myElement;
-
-    QObject::connect(gamemodel, SIGNAL(moveChoosed(QVariant)),
-                     myElement, SLOT(moveChoosed(QVariant)));
+    gamemodel->warmUp(); // idle time until the first move: prepare the transposition table
 
     return app.exec();
 }
@@ -0,0 +1,39 @@
+#ifndef MOVERESULT_H
+#define MOVERESULT_H
+
+#include <QObject>
+#include <QMetaType>
+
+/**
+ * A move committed to the game and the state of the game after it, passed by value to QML.
+ */
+class MoveResult
+{
+    Q_GADGET
+    Q_PROPERTY(int column MEMBER column)
+    Q_PROPERTY(int row MEMBER row)
+    Q_PROPERTY(int player MEMBER player)
+    Q_PROPERTY(State state MEMBER state)
+    Q_PROPERTY(quint64 winningCells MEMBER winningCells)
+public:
+    /**
+     * State of the game, same values as GameModel::state.
+     */
+    enum State {
+        Playing = -1,
+        Draw = 0,
+        FirstPlayerWins = 1,
+        SecondPlayerWins = 2
+    };
+    Q_ENUM(State)
+
+    int column;          // 0-based column of the move
+    int row;             // 0-based row of the move, -1 if the column could not be played
+    int player;          // 1 first player, 2 second player, 0 if the move was not played
+    State state;         // state of the game after the move
+    quint64 winningCells; // cells of the winning alignment, bit column * rows + row, 0 unless a player wins
+};
+
+Q_DECLARE_METATYPE(MoveResult)
+
+#endif // MOVERESULT_H
@@ -0,0 +1,53 @@
+#include "timemanager.hpp"
+
+#include <QSettings>
+
+#include <algorithm>
+
+const int TimeManager::MIN_MOVE_TIME;
+
+TimeManager TimeManager::fromSettings() {
+    TimeManager time;
+
+    QSettings settings;
+    settings.beginGroup("engine");
+    time.gameBudget = settings.value("gameBudget", time.gameBudget).toInt();
+    settings.endGroup();
+
+    return time;
+}
+
+void TimeManager::newGame() {
+    used = 0;
+}
+
+MoveBudget TimeManager::moveBudget(const Position &position) const {
+    MoveBudget budget;
+    if (gameBudget < 0) {
+        return budget;
+    }
+
+    const qint64 remaining = std::max<qint64>(0, gameBudget - used);
+    const int empty = Position::WIDTH * Position::HEIGHT - position.nbMoves();
+    const int movesLeft = std::max(1, (empty + 1) / 2); // moves of the engine up to the end of the game
+    const qint64 share = remaining / movesLeft;
+
+    // weight of the phase, in halves of the share
+    int weight;
+    if (position.nbMoves() < 8) {
+        weight = 1; // opening
+    } else if (position.nbMoves() < 28) {
+        weight = 3; // midgame
+    } else {
+        weight = 2; // endgame
+    }
+
+    // the share is computed again from the remaining time for every move: overspending is paid by the next ones
+    budget.soft = static_cast<int>(std::max<qint64>(MIN_MOVE_TIME / 2, share * weight / 2));
+    budget.hard = static_cast<int>(std::max<qint64>(MIN_MOVE_TIME, std::min(remaining, share * weight * 3 / 2)));
+    return budget;
+}
+
+void TimeManager::spent(qint64 elapsed) {
+    used += elapsed;
+}
@@ -0,0 +1,62 @@
+#ifndef TIMEMANAGER_H
+#define TIMEMANAGER_H
+
+#include <QtGlobal>
+
+// include custom classes
+#include "brain/Position.hpp"
+
+using namespace GameSolver::Connect4;
+
+/**
+ * Time allowed to the search of a move, in milliseconds, a negative time is unlimited.
+ */
+struct MoveBudget {
+    int soft = -1; // no deeper iteration is started once it is spent
+    int hard = -1; // the search is stopped, the move of its last complete iteration is played
+};
+
+/**
+ * Share the time of the engine for a whole game between its moves.
+ *
+ * The game budget is read from the application settings (group "engine"):
+ * - gameBudget: milliseconds of search for all the moves of the engine in a game, -1 (the default) for unlimited
+ *
+ * The share of a move depends on the number of moves left to the engine and on the phase of the game:
+ * the opening is mostly answered by the opening book and the endgame is solved quickly,
+ * the midgame gets the larger shares.
+ * A move never gets less than MIN_MOVE_TIME, so the shallow iterations complete once the budget is spent.
+ */
+class TimeManager
+{
+public:
+    static const int MIN_MOVE_TIME = 200; // milliseconds, the hard limit of a move, even past the game budget
+
+    int gameBudget = -1;
+
+    /**
+     * Read the game budget from the application settings, a missing key keeps the default value.
+     */
+    static TimeManager fromSettings();
+
+    /**
+     * Start a new game with the whole budget.
+     */
+    void newGame();
+
+    /**
+     * @return the budget of the search of the next move of the engine in a position.
+     */
+    MoveBudget moveBudget(const Position &position) const;
+
+    /**
+     * Charge the time spent by a search to the game.
+     * @param elapsed: milliseconds
+     */
+    void spent(qint64 elapsed);
+
+private:
+    qint64 used = 0; // milliseconds spent in the current game
+};
+
+#endif // TIMEMANAGER_H